@@ -31,10 +31,8 @@ void bidirectional_stream_copy(Socket& socket, string_view peer_name) {
       _input,
       Direction::In,
       [&] {
-          string data;
-          data.resize(_outbound.writer().available_capacity());
-          _input.read(data);
-          _outbound.writer().push(move(data));
+          auto& writer = _outbound.writer();
+          writer.commit(_input.read_into(writer.reserve(writer.available_capacity())));
           if (_input.eof()) {
               _outbound.writer().close();
           }
@@ -57,7 +55,8 @@ void bidirectional_stream_copy(Socket& socket, string_view peer_name) {
       Direction::Out,
       [&] {
           if (_outbound.reader().bytes_buffered()) {
-              _outbound.reader().pop(socket.write(_outbound.reader().peek()));
+              auto& reader = _outbound.reader();
+              reader.pop(socket.write(reader.peek_all(reader.bytes_buffered())));
           }
           if (_outbound.reader().is_finished()) {
               socket.shutdown(SHUT_WR);
@@ -82,10 +81,8 @@ void bidirectional_stream_copy(Socket& socket, string_view peer_name) {
       socket,
       Direction::In,
       [&] {
-          string data;
-          data.resize(_inbound.writer().available_capacity());
-          socket.read(data);
-          _inbound.writer().push(move(data));
+          auto& writer = _inbound.writer();
+          writer.commit(socket.read_into(writer.reserve(writer.available_capacity())));
           if (socket.eof()) {
               _inbound.writer().close();
           }
@@ -108,7 +105,8 @@ void bidirectional_stream_copy(Socket& socket, string_view peer_name) {
       Direction::Out,
       [&] {
           if (_inbound.reader().bytes_buffered()) {
-              _inbound.reader().pop(_output.write(_inbound.reader().peek()));
+              auto& reader = _inbound.reader();
+              reader.pop(_output.write(reader.peek_all(reader.bytes_buffered())));
           }
           if (_inbound.reader().is_finished()) {
               _output.close();
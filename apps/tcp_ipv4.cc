@@ -3,6 +3,7 @@
 #include "tcp_minnow_socket.hh"
 #include "tun.hh"
 
+#include <algorithm>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
@@ -30,12 +31,31 @@ void show_usage(const char* argv0, const char* msg) {
          << "   -s <port>       Set source port (client mode only)              (random)\n\n"
 
          << "   -w <winsz>      Use a window of <winsz> bytes                   " << TCPConfig::MAX_PAYLOAD_SIZE
-         << "\n\n"
+         << "\n"
+         << "                   (otherwise autotuned from " << TCPConfig::RECV_CAPACITY_DFLT << " up to "
+         << TCPConfig::RECV_CAPACITY_MAX_DFLT << " bytes)\n\n"
 
          << "   -t <tmout>      Set rt_timeout to tmout                         " << TCPConfig::TIMEOUT_DFLT
-         << "\n\n"
+         << "\n"
+         << "                   (and the RTO estimate's lower bound, if higher)\n\n"
 
-         << "   -d <tundev>     Connect to tun <tundev>                         " << TUN_DFLT << "\n\n"
+         << "   -m <mss>        Send and accept segments of up to <mss> bytes   " << TCPConfig::MAX_PAYLOAD_SIZE
+         << "\n"
+         << "                   (bounded by the tun device's MTU)\n\n"
+
+         << "   -da <ms>        Delay ACKs of in-order data by up to <ms> ms    " << TCPConfig::DELAYED_ACK_DFLT
+         << "\n"
+         << "                   (0 acknowledges every segment at once)\n\n"
+
+         << "   -pace <rate>    Pace segments at <rate> bytes/s, or at the      (no pacing,\n"
+         << "                   congestion controller's rate if <rate> is 0     except with bbr)\n\n"
+
+         << "   -cc <algo>      Congestion control: none, reno, cubic or bbr    "
+         << to_string(TCPConfig {}.congestion_control) << "\n\n"
+
+         << "   -d <tundev>     Connect to tun <tundev>                         " << TUN_DFLT << "\n"
+         << "   -co             Offload checksums to the tun device, and skip   (verify all)\n"
+         << "                   those the kernel vouches for\n\n"
 
          << "   -Lu <loss>      Set uplink loss to <rate> (float in 0..1)       (no loss)\n"
          << "   -Ld <loss>      Set downlink loss to <rate> (float in 0..1)     (no loss)\n\n"
@@ -55,12 +75,13 @@ void check_argc(const span<char*>& args, size_t curr, const char* err) {
     }
 }
 
-tuple<TCPConfig, FdAdapterConfig, bool, const char*> get_config(const span<char*>& args) {
+tuple<TCPConfig, FdAdapterConfig, bool, const char*, bool> get_config(const span<char*>& args) {
     TCPConfig c_fsm {};
     c_fsm.isn = Wrap32 {random_device()()};
 
     FdAdapterConfig c_filt {};
     const char* tundev = nullptr;
+    bool checksum_offload = false;
 
     size_t curr = 1;
     bool listen = false;
@@ -87,11 +108,39 @@ tuple<TCPConfig, FdAdapterConfig, bool, const char*> get_config(const span<char*
         } else if (strncmp("-w", args[curr], 3) == 0) {
             check_argc(args, curr, "ERROR: -w requires one argument.");
             c_fsm.recv_capacity = strtol(args[curr + 1], nullptr, 0);
+            c_fsm.recv_capacity_max = c_fsm.recv_capacity;
             curr += 2;
 
         } else if (strncmp("-t", args[curr], 3) == 0) {
             check_argc(args, curr, "ERROR: -t requires one argument.");
             c_fsm.rt_timeout = strtol(args[curr + 1], nullptr, 0);
+            c_fsm.rt_timeout_min = min(c_fsm.rt_timeout_min, c_fsm.rt_timeout);
+            curr += 2;
+
+        } else if (strncmp("-m", args[curr], 3) == 0) {
+            check_argc(args, curr, "ERROR: -m requires one argument.");
+            c_fsm.mss = static_cast<uint16_t>(strtol(args[curr + 1], nullptr, 0));
+            curr += 2;
+
+        } else if (strncmp("-da", args[curr], 3) == 0) {
+            check_argc(args, curr, "ERROR: -da requires one argument.");
+            c_fsm.delayed_ack_timeout = static_cast<uint16_t>(strtol(args[curr + 1], nullptr, 0));
+            curr += 2;
+
+        } else if (strncmp("-pace", args[curr], 6) == 0) {
+            check_argc(args, curr, "ERROR: -pace requires one argument.");
+            c_fsm.pacing = true;
+            c_fsm.pacing_rate = strtoull(args[curr + 1], nullptr, 0);
+            curr += 2;
+
+        } else if (strncmp("-cc", args[curr], 3) == 0) {
+            check_argc(args, curr, "ERROR: -cc requires one argument.");
+            const auto algorithm = congestion_control_from_name(args[curr + 1]);
+            if (not algorithm.has_value()) {
+                show_usage(args[0], "ERROR: unknown congestion-control algorithm.");
+                exit(1);
+            }
+            c_fsm.congestion_control = algorithm.value();
             curr += 2;
 
         } else if (strncmp("-d", args[curr], 3) == 0) {
@@ -99,6 +148,10 @@ tuple<TCPConfig, FdAdapterConfig, bool, const char*> get_config(const span<char*
             tundev = args[curr + 1];
             curr += 2;
 
+        } else if (strncmp("-co", args[curr], 4) == 0) {
+            checksum_offload = true;
+            curr += 1;
+
         } else if (strncmp("-Lu", args[curr], 3) == 0) {
             check_argc(args, curr, "ERROR: -Lu requires one argument.");
             const float lossrate = strtof(args[curr + 1], nullptr);
@@ -137,7 +190,7 @@ tuple<TCPConfig, FdAdapterConfig, bool, const char*> get_config(const span<char*
         c_filt.source = {source_address, source_port};
     }
 
-    return make_tuple(c_fsm, c_filt, listen, tundev);
+    return make_tuple(c_fsm, c_filt, listen, tundev, checksum_offload);
 }
 } // namespace
 
@@ -154,9 +207,9 @@ int main(int argc, char** argv) {
             return EXIT_FAILURE;
         }
 
-        auto [c_fsm, c_filt, listen, tun_dev_name] = get_config(args);
+        auto [c_fsm, c_filt, listen, tun_dev_name, checksum_offload] = get_config(args);
         LossyTCPOverIPv4MinnowSocket tcp_socket(LossyFdAdapter<TCPOverIPv4OverTunFdAdapter>(
-          TCPOverIPv4OverTunFdAdapter(TunFD(tun_dev_name == nullptr ? TUN_DFLT : tun_dev_name))));
+          TCPOverIPv4OverTunFdAdapter(TunFD(tun_dev_name == nullptr ? TUN_DFLT : tun_dev_name, checksum_offload))));
 
         if (listen) {
             tcp_socket.listen_and_accept(c_fsm, c_filt);
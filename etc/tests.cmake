@@ -45,6 +45,7 @@ ttest(recv_reorder)
 ttest(recv_reorder_more)
 ttest(recv_close)
 ttest(recv_special)
+ttest(recv_sack)
 
 ttest(send_connect)
 ttest(send_transmit)
@@ -53,10 +54,24 @@ ttest(send_window)
 ttest(send_ack)
 ttest(send_close)
 ttest(send_extra)
+ttest(send_rto)
+ttest(send_fast_retx)
+ttest(send_sack)
+ttest(send_pacing)
+ttest(send_fast_open)
+ttest(peer_delayed_ack)
+ttest(peer_send_buffer)
 
 ttest(net_interface)
 
 ttest(router)
+ttest(forwarding_table)
+ttest(checksum)
+
+ttest(tcp_demux)
+ttest(tcp_listen)
+ttest(tcp_wrap)
+ttest(tcp_unwrap)
 
 add_custom_target (check0 COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --stop-on-failure --timeout 12 -R 'webget|^byte_stream_')
 
@@ -70,7 +85,7 @@ add_custom_target (check3 COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --s
 
 add_custom_target (check5 COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --stop-on-failure --timeout 12 -R '^net_interface')
 
-add_custom_target (check6 COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --stop-on-failure --timeout 12 -R '^net_interface|^router')
+add_custom_target (check6 COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --stop-on-failure --timeout 12 -R '^net_interface|^router|^forwarding_table')
 
 ###
 
@@ -90,3 +105,11 @@ set_tests_properties(${compile_name_opt} PROPERTIES FIXTURES_SETUP compile_opt)
 
 stest(byte_stream_speed_test)
 stest(reassembler_speed_test)
+stest(checksum_speed_test)
+stest(router_speed_test)
+stest(congestion_control_speed_test)
+stest(window_scaling_speed_test)
+stest(tcp_demux_speed_test)
+stest(fast_open_speed_test)
+stest(tcp_wrap_speed_test)
+stest(tcp_unwrap_speed_test)
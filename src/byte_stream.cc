@@ -1,26 +1,56 @@
 #include "byte_stream.hh"
 
+#include <cstring>
+
 using namespace std;
 
 ByteStream::ByteStream(uint64_t capacity) : capacity_(capacity) {}
 
+void ByteStream::grow_capacity(uint64_t capacity) {
+    if (capacity <= capacity_) {
+        return;
+    }
+
+    /* retained bytes are kept too; a ring not yet mapped is mapped at the new capacity */
+    if (buffer_.size() > 0) {
+        buffer_.grow(capacity, total_bytes_released_, total_bytes_pushed_);
+    }
+    capacity_ = capacity;
+}
+
 bool Writer::is_closed() const {
     return closed_;
 }
 
 void Writer::push(string data) {
-    if (is_closed() or has_error()) {
+    auto space = reserve(data.size());
+    if (space.empty()) {
         return;
     }
-    
-    auto asize = min(available_capacity(), data.size());
-    if (asize == 0) {
+
+    memcpy(space.data(), data.data(), space.size());
+    commit(space.size());
+}
+
+span<char> Writer::reserve(uint64_t len) {
+    if (is_closed() or has_error()) {
+        return {};
+    }
+
+    if (buffer_.size() == 0 and len > 0) {
+        buffer_.grow(capacity_, total_bytes_released_, total_bytes_pushed_);
+    }
+
+    /* the ring is mirrored, so the free region is contiguous even when it wraps */
+    return {buffer_.at(total_bytes_pushed_), min(available_capacity(), len)};
+}
+
+void Writer::commit(uint64_t len) {
+    if (is_closed() or has_error()) {
         return;
     }
 
-    total_bytes_pushed_ += asize;
-    buffer_.push(data.substr(0, asize));
-    total_bytes_buffered_ += asize;
+    total_bytes_pushed_ += min(available_capacity(), len);
 }
 
 void Writer::close() {
@@ -28,7 +58,7 @@ void Writer::close() {
 }
 
 uint64_t Writer::available_capacity() const {
-    return capacity_ - total_bytes_buffered_;
+    return capacity_ - (total_bytes_pushed_ - total_bytes_released_);
 }
 
 uint64_t Writer::bytes_pushed() const {
@@ -36,7 +66,7 @@ uint64_t Writer::bytes_pushed() const {
 }
 
 bool Reader::is_finished() const {
-    return closed_ and (total_bytes_buffered_ == 0);
+    return closed_ and (total_bytes_pushed_ == total_bytes_popped_);
 }
 
 uint64_t Reader::bytes_popped() const {
@@ -44,7 +74,13 @@ uint64_t Reader::bytes_popped() const {
 }
 
 string_view Reader::peek() const {
-    return buffer_.empty() ? string_view {} : string_view {buffer_.front()}.substr(prefix_bytes_poped_);
+    return {buffer_.at(total_bytes_popped_), bytes_buffered()};
+}
+
+vector<string_view> Reader::peek_all(uint64_t len) const {
+    /* the mirrored ring never splits the buffered bytes, so one view always suffices */
+    const auto view = peek().substr(0, len);
+    return view.empty() ? vector<string_view> {} : vector<string_view> {view};
 }
 
 void Reader::pop(uint64_t len) {
@@ -52,23 +88,38 @@ void Reader::pop(uint64_t len) {
         return;
     }
 
+    /* with bytes already retained, these are retained behind them; otherwise their space is free at once */
+    const bool retaining = bytes_retained() > 0;
+    total_bytes_popped_ += len;
+    if (not retaining) {
+        total_bytes_released_ = total_bytes_popped_;
+    }
+}
+
+void Reader::pop_and_retain(uint64_t len) {
+    if (len > bytes_buffered()) {
+        return;
+    }
+
     total_bytes_popped_ += len;
-    total_bytes_buffered_ -= len;
-
-    /* lazy pop, record the poped prefix length */
-    while (len > 0) {
-        auto str_size_left = buffer_.front().size() - prefix_bytes_poped_;
-        if (str_size_left <= len) {
-            prefix_bytes_poped_ = 0;
-            len -= str_size_left;
-            buffer_.pop();
-        } else {
-            prefix_bytes_poped_ += len;
-            break;
-        }
+}
+
+string_view Reader::retained(uint64_t first_index, uint64_t len) const {
+    if (first_index < total_bytes_released_ or first_index > total_bytes_popped_) {
+        return {};
     }
+
+    return {buffer_.at(first_index), min(len, total_bytes_popped_ - first_index)};
+}
+
+void Reader::release(uint64_t len) {
+    total_bytes_released_ += min(len, bytes_retained());
+}
+
+uint64_t Reader::bytes_retained() const {
+    return total_bytes_popped_ - total_bytes_released_;
 }
 
 uint64_t Reader::bytes_buffered() const {
-    return total_bytes_buffered_;
+    return total_bytes_pushed_ - total_bytes_popped_;
 }
@@ -1,9 +1,12 @@
 #pragma once
 
 #include <cstdint>
-#include <queue>
+#include <span>
 #include <string>
 #include <string_view>
+#include <vector>
+
+#include "ring_buffer.hh"
 
 class Reader;
 class Writer;
@@ -21,16 +24,21 @@ class ByteStream {
     void set_error() { error_ = true; };       // Signal that the stream suffered an error.
     bool has_error() const { return error_; }; // Has the stream had an error?
 
+    // Raise the capacity, growing the ring in place (the bytes held and retained stay; see RingBuffer::grow)
+    void grow_capacity(uint64_t capacity);
+    uint64_t capacity() const { return capacity_; }
+
   protected:
     // Please add any additional state to the ByteStream here, and not to the Writer and Reader interfaces.
-    std::queue<std::string> buffer_ {};
     uint64_t capacity_;
+    /* ring of the capacity, byte i of the stream lives at buffer_.at(i). It is mapped on the first reserve(), so
+       a stream that never carries data (an idle connection's) costs no mappings. */
+    RingBuffer buffer_ {0};
     bool error_ {};
     bool closed_ {};
     uint64_t total_bytes_pushed_ {};
     uint64_t total_bytes_popped_ {};
-    uint64_t total_bytes_buffered_ {};
-    uint64_t prefix_bytes_poped_ {};
+    uint64_t total_bytes_released_ {}; // popped bytes below this no longer hold space in the ring
 };
 
 class Writer : public ByteStream {
@@ -38,6 +46,10 @@ class Writer : public ByteStream {
     void push(std::string data); // Push data to stream, but only as much as available capacity allows.
     void close();                // Signal that the stream has reached its ending. Nothing more will be written.
 
+    // Zero-copy alternative to push(): fill the span returned by reserve() in place, then commit() the bytes used
+    std::span<char> reserve(uint64_t len); // Writable space for up to `len` bytes at the end of the stream
+    void commit(uint64_t len);             // Append the first `len` bytes of the reserved space to the stream
+
     bool is_closed() const;              // Has the stream been closed?
     uint64_t available_capacity() const; // How many bytes can be pushed to the stream right now?
     uint64_t bytes_pushed() const;       // Total number of bytes cumulatively pushed to the stream
@@ -45,12 +57,20 @@ class Writer : public ByteStream {
 
 class Reader : public ByteStream {
   public:
-    std::string_view peek() const; // Peek at the next bytes in the buffer
+    std::string_view peek() const; // Peek at all buffered bytes, as one contiguous view
+    std::vector<std::string_view> peek_all(uint64_t len) const; // Scatter-gather view of up to `len` bytes
     void pop(uint64_t len);        // Remove `len` bytes from the buffer
 
     bool is_finished() const;        // Is the stream finished (closed and fully popped)?
     uint64_t bytes_buffered() const; // Number of bytes currently buffered (pushed and not popped)
     uint64_t bytes_popped() const;   // Total number of bytes cumulatively popped from stream
+
+    // Popping without freeing the space, for a sender that may need the bytes again: retained bytes stay
+    // readable by stream index, and count against the capacity, until released oldest first
+    void pop_and_retain(uint64_t len); // Remove `len` bytes from the buffer but keep them
+    std::string_view retained(uint64_t first_index, uint64_t len) const; // View of retained bytes
+    void release(uint64_t len);      // Free the space of the oldest `len` retained bytes
+    uint64_t bytes_retained() const; // Number of bytes popped and not yet released
 };
 
 /*
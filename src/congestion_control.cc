@@ -0,0 +1,215 @@
+#include "congestion_control.hh"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+using namespace std;
+
+unique_ptr<CongestionController> make_congestion_controller(const CongestionControl algorithm, const uint64_t mss) {
+    switch (algorithm) {
+        case CongestionControl::Reno:
+            return make_unique<Reno>(mss);
+        case CongestionControl::Cubic:
+            return make_unique<Cubic>(mss);
+        case CongestionControl::BBR:
+            return make_unique<BBR>(mss);
+        case CongestionControl::None:
+            break;
+    }
+    return nullptr;
+}
+
+/* Reno */
+
+void Reno::on_ack(const AckSample& sample) {
+    /* slow start: grow by the bytes acked, so that an ACK covering several segments (a delayed ACK) counts for
+       each of them, up to a limit (appropriate byte counting, RFC 3465) */
+    if (cwnd_ < ssthresh_) {
+        cwnd_ += min(sample.bytes_acked, ABC_LIMIT_SEGMENTS * mss_);
+        return;
+    }
+
+    /* congestion avoidance: one MSS per window acked */
+    bytes_acked_in_window_ += sample.bytes_acked;
+    if (bytes_acked_in_window_ >= cwnd_) {
+        bytes_acked_in_window_ -= cwnd_;
+        cwnd_ += mss_;
+    }
+}
+
+void Reno::on_loss(const uint64_t now_ms [[maybe_unused]], const uint64_t bytes_in_flight) {
+    ssthresh_ = max(bytes_in_flight / 2, 2 * mss_);
+    cwnd_ = ssthresh_;
+    bytes_acked_in_window_ = 0;
+}
+
+void Reno::on_timeout(const uint64_t now_ms [[maybe_unused]], const uint64_t bytes_in_flight) {
+    ssthresh_ = max(bytes_in_flight / 2, 2 * mss_);
+    cwnd_ = mss_;
+    bytes_acked_in_window_ = 0;
+}
+
+/* CUBIC */
+
+void Cubic::on_ack(const AckSample& sample) {
+    const auto mss = static_cast<double>(mss_);
+    const auto bytes_acked = static_cast<double>(sample.bytes_acked);
+    if (sample.rtt_ms.has_value()) {
+        last_rtt_ms_ = sample.rtt_ms.value();
+    }
+
+    if (cwnd_ < ssthresh_) {
+        cwnd_ += min(bytes_acked, static_cast<double>(ABC_LIMIT_SEGMENTS) * mss);
+        return;
+    }
+
+    /* a new epoch starts with the first ack after slow start or a reduction */
+    const double w = cwnd_ / mss;
+    if (not epoch_start_ms_.has_value()) {
+        epoch_start_ms_ = sample.now_ms;
+        if (w < w_max_) {
+            k_ = cbrt((w_max_ - w) / C);
+        } else {
+            k_ = 0;
+            w_max_ = w;
+        }
+        w_est_ = w;
+    }
+
+    /* where the cubic curve will be one RTT from now, limited to 1.5x growth per RTT */
+    const double t = static_cast<double>(sample.now_ms + last_rtt_ms_ - epoch_start_ms_.value()) / 1000;
+    double target = clamp(C * pow(t - k_, 3) + w_max_, w, 1.5 * w);
+
+    /* never grow more slowly than Reno would have */
+    constexpr double alpha = 3 * (1 - BETA) / (1 + BETA);
+    w_est_ += alpha * (bytes_acked / mss) / w;
+    target = max(target, w_est_);
+
+    cwnd_ += (target - w) / w * bytes_acked;
+}
+
+void Cubic::reduce() {
+    /* fast convergence: release bandwidth faster if the window is still shrinking */
+    const double w = cwnd_ / static_cast<double>(mss_);
+    w_max_ = w < w_max_ ? w * (1 + BETA) / 2 : w;
+    ssthresh_ = max(cwnd_ * BETA, 2.0 * static_cast<double>(mss_));
+    epoch_start_ms_.reset();
+}
+
+void Cubic::on_loss(const uint64_t now_ms [[maybe_unused]], const uint64_t bytes_in_flight [[maybe_unused]]) {
+    reduce();
+    cwnd_ = ssthresh_;
+}
+
+void Cubic::on_timeout(const uint64_t now_ms [[maybe_unused]], const uint64_t bytes_in_flight [[maybe_unused]]) {
+    reduce();
+    cwnd_ = static_cast<double>(mss_);
+}
+
+/* BBR */
+
+namespace {
+constexpr array<double, 8> probe_bw_gains {1.25, 0.75, 1, 1, 1, 1, 1, 1};
+} // namespace
+
+double BBR::bottleneck_bandwidth() const {
+    return *max_element(bandwidth_by_round_.begin(), bandwidth_by_round_.end());
+}
+
+uint64_t BBR::bdp() const {
+    if (not min_rtt_ms_.has_value()) {
+        return 0;
+    }
+    const auto min_rtt = static_cast<double>(max<uint64_t>(min_rtt_ms_.value(), 1));
+    return static_cast<uint64_t>(bottleneck_bandwidth() * min_rtt);
+}
+
+void BBR::advance_round(const uint64_t now_ms) {
+    if (not min_rtt_ms_.has_value() or now_ms - round_start_ms_ < max<uint64_t>(min_rtt_ms_.value(), 1)) {
+        return;
+    }
+    round_start_ms_ = now_ms;
+    ++rounds_;
+
+    if (state_ == State::Startup) {
+        const double bandwidth = bottleneck_bandwidth();
+        if (bandwidth >= full_bandwidth_ * 1.25) {
+            full_bandwidth_ = bandwidth;
+            full_bandwidth_rounds_ = 0;
+        } else if (++full_bandwidth_rounds_ >= 3) {
+            state_ = State::Drain;
+            pacing_gain_ = 1 / HIGH_GAIN;
+            cwnd_gain_ = 1;
+        }
+    } else if (state_ == State::ProbeBW) {
+        cycle_index_ = (cycle_index_ + 1) % probe_bw_gains.size();
+        pacing_gain_ = probe_bw_gains.at(cycle_index_);
+        cwnd_gain_ = pacing_gain_;
+    }
+
+    bandwidth_by_round_.push_back(0);
+    if (bandwidth_by_round_.size() > BW_WINDOW_ROUNDS) {
+        bandwidth_by_round_.pop_front();
+    }
+}
+
+void BBR::on_ack(const AckSample& sample) {
+    if (sample.rtt_ms.has_value()
+        and (not min_rtt_ms_.has_value() or sample.rtt_ms.value() <= min_rtt_ms_.value()
+             or sample.now_ms - min_rtt_stamp_ms_ > MIN_RTT_WINDOW_MS)) {
+        min_rtt_ms_ = sample.rtt_ms;
+        min_rtt_stamp_ms_ = sample.now_ms;
+    }
+    if (sample.delivery_rate.has_value()) {
+        bandwidth_by_round_.back() = max(bandwidth_by_round_.back(), sample.delivery_rate.value());
+    }
+
+    advance_round(sample.now_ms);
+
+    /* Drain ends once the queue built during Startup is gone */
+    if (state_ == State::Drain and sample.bytes_in_flight <= bdp()) {
+        state_ = State::ProbeBW;
+        cycle_index_ = 0;
+        pacing_gain_ = probe_bw_gains.at(cycle_index_);
+        cwnd_gain_ = pacing_gain_;
+    }
+
+    /* grow toward the target; before the pipe is full, grow like slow start. The sender paces at pacing_rate()
+       (see needs_pacing), and the window caps what that puts in flight, so it follows the gain cycle too (plus
+       a little slack for ack granularity). */
+    const uint64_t target = bdp() ? static_cast<uint64_t>(cwnd_gain_ * static_cast<double>(bdp())) + 2 * mss_
+                                  : INITIAL_WINDOW_SEGMENTS * mss_;
+    if (state_ != State::Startup) {
+        cwnd_ = min(cwnd_ + sample.bytes_acked, target);
+    } else if (cwnd_ < target or bdp() == 0) {
+        cwnd_ += sample.bytes_acked;
+    }
+    cwnd_ = max(cwnd_, 4 * mss_);
+}
+
+void BBR::on_loss(const uint64_t now_ms [[maybe_unused]], const uint64_t bytes_in_flight [[maybe_unused]]) {
+    /* the model already accounts for the bandwidth, so an isolated loss is not a congestion signal. But loss in
+       Startup means the bottleneck queue overflowed: the pipe is full, so stop probing and fall back to one
+       BDP (as BBRv2 does) rather than keep the overshoot in flight. */
+    if (state_ != State::Startup or bdp() == 0) {
+        return;
+    }
+    state_ = State::Drain;
+    pacing_gain_ = 1 / HIGH_GAIN;
+    cwnd_gain_ = 1;
+    cwnd_ = max(min(cwnd_, bdp() + 2 * mss_), 4 * mss_);
+}
+
+void BBR::on_timeout(const uint64_t now_ms [[maybe_unused]], const uint64_t bytes_in_flight [[maybe_unused]]) {
+    /* start over from a small window, but keep the path model */
+    cwnd_ = 4 * mss_;
+}
+
+optional<double> BBR::pacing_rate() const {
+    const double bandwidth = bottleneck_bandwidth();
+    if (bandwidth == 0) {
+        return {};
+    }
+    return pacing_gain_ * bandwidth;
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "congestion_control_algorithm.hh"
+
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <optional>
+
+// What the sender learned from an acknowledgment of new data
+struct AckSample {
+    uint64_t now_ms {};                     // the sender's clock
+    uint64_t bytes_acked {};                // sequence numbers newly acknowledged
+    uint64_t bytes_in_flight {};            // sequence numbers still outstanding after this ack
+    std::optional<uint64_t> rtt_ms {};      // RTT of the newest segment acked, if it was never retransmitted
+    std::optional<double> delivery_rate {}; // bytes/ms delivered over that segment's lifetime
+};
+
+// \brief The interface a TCPSender consults to limit how much it sends.
+// All quantities are in bytes (sequence numbers) and milliseconds of the sender's clock.
+class CongestionController {
+  public:
+    explicit CongestionController(uint64_t mss) : mss_(mss) {}
+    virtual ~CongestionController() = default;
+
+    // New data was acknowledged
+    virtual void on_ack(const AckSample& sample) = 0;
+
+    // A loss was detected without a timeout (e.g. by duplicate ACKs)
+    virtual void on_loss(uint64_t now_ms, uint64_t bytes_in_flight) = 0;
+
+    // The retransmission timer expired
+    virtual void on_timeout(uint64_t now_ms, uint64_t bytes_in_flight) = 0;
+
+    // How many sequence numbers may be outstanding
+    virtual uint64_t congestion_window() const = 0;
+
+    // The rate (bytes/ms) the controller wants the sender to pace at, if any
+    virtual std::optional<double> pacing_rate() const { return {}; }
+
+    // Whether the controller sets the sending rate through pacing_rate(), with the window only a cap (a sender
+    // that sent each window in one burst would overrun the queue the controller means to keep empty)
+    virtual bool needs_pacing() const { return false; }
+
+    // Is the window still doubling every round trip?
+    virtual bool in_slow_start() const { return false; }
+
+    uint64_t mss() const { return mss_; }
+
+    // The segment size changed (e.g. the peer accepts smaller segments than the sender's own limit)
+    void set_mss(uint64_t mss) { mss_ = mss; }
+
+  protected:
+    static constexpr uint64_t INITIAL_WINDOW_SEGMENTS = 10; // RFC 6928
+    static constexpr uint64_t ABC_LIMIT_SEGMENTS = 2;       // most one ACK may grow slow start by (RFC 3465 L)
+
+    uint64_t mss_;
+};
+
+// Build the controller for `algorithm` (nullptr for CongestionControl::None)
+std::unique_ptr<CongestionController> make_congestion_controller(CongestionControl algorithm, uint64_t mss);
+
+// \brief Slow start, then additive increase; halve the window on loss (RFC 5681)
+class Reno : public CongestionController {
+  public:
+    explicit Reno(uint64_t mss) : CongestionController(mss) {}
+
+    void on_ack(const AckSample& sample) override;
+    void on_loss(uint64_t now_ms, uint64_t bytes_in_flight) override;
+    void on_timeout(uint64_t now_ms, uint64_t bytes_in_flight) override;
+    uint64_t congestion_window() const override { return cwnd_; }
+    bool in_slow_start() const override { return cwnd_ < ssthresh_; }
+
+  private:
+    uint64_t cwnd_ {INITIAL_WINDOW_SEGMENTS * mss_};
+    uint64_t ssthresh_ {UINT64_MAX};
+    uint64_t bytes_acked_in_window_ {}; // counts toward the next increase in congestion avoidance
+};
+
+// \brief Window grows as a cubic function of the time since the last loss (RFC 9438)
+class Cubic : public CongestionController {
+  public:
+    explicit Cubic(uint64_t mss) : CongestionController(mss) {}
+
+    void on_ack(const AckSample& sample) override;
+    void on_loss(uint64_t now_ms, uint64_t bytes_in_flight) override;
+    void on_timeout(uint64_t now_ms, uint64_t bytes_in_flight) override;
+    uint64_t congestion_window() const override { return static_cast<uint64_t>(cwnd_); }
+    bool in_slow_start() const override { return cwnd_ < ssthresh_; }
+
+  private:
+    static constexpr double C = 0.4;
+    static constexpr double BETA = 0.7;
+
+    void reduce();
+
+    double cwnd_ = static_cast<double>(INITIAL_WINDOW_SEGMENTS * mss_); // bytes, kept fractional between acks
+    double ssthresh_ = std::numeric_limits<double>::infinity();
+
+    /* window (in segments) before the last reduction, and when the current epoch began */
+    double w_max_ {};
+    double k_ {};
+    std::optional<uint64_t> epoch_start_ms_ {};
+    double w_est_ {}; // Reno-friendly estimate, in segments
+    uint64_t last_rtt_ms_ {};
+};
+
+// \brief A simplified BBR: estimate bottleneck bandwidth and min RTT, and keep about one BDP in flight,
+// probing for more bandwidth one round in eight
+class BBR : public CongestionController {
+  public:
+    explicit BBR(uint64_t mss) : CongestionController(mss) {}
+
+    void on_ack(const AckSample& sample) override;
+    void on_loss(uint64_t now_ms, uint64_t bytes_in_flight) override;
+    void on_timeout(uint64_t now_ms, uint64_t bytes_in_flight) override;
+    uint64_t congestion_window() const override { return cwnd_; }
+    std::optional<double> pacing_rate() const override;
+    bool needs_pacing() const override { return true; }
+
+  private:
+    enum class State : uint8_t { Startup, Drain, ProbeBW };
+
+    static constexpr double HIGH_GAIN = 2.885; // 2/ln(2)
+    static constexpr uint64_t BW_WINDOW_ROUNDS = 10;
+    static constexpr uint64_t MIN_RTT_WINDOW_MS = 10000;
+
+    double bottleneck_bandwidth() const;
+    uint64_t bdp() const;
+    void advance_round(uint64_t now_ms);
+
+    State state_ {State::Startup};
+    uint64_t cwnd_ {INITIAL_WINDOW_SEGMENTS * mss_};
+
+    /* windowed max of delivery rate (one entry per round) and windowed min of RTT */
+    std::deque<double> bandwidth_by_round_ {0};
+    std::optional<uint64_t> min_rtt_ms_ {};
+    uint64_t min_rtt_stamp_ms_ {};
+
+    /* rounds are approximated as one min RTT of the sender's clock */
+    uint64_t round_start_ms_ {};
+    uint64_t rounds_ {};
+
+    /* Startup exits once bandwidth stops growing by 25% for three rounds */
+    double full_bandwidth_ {};
+    uint64_t full_bandwidth_rounds_ {};
+
+    unsigned cycle_index_ {};
+    double pacing_gain_ {HIGH_GAIN};
+    double cwnd_gain_ {HIGH_GAIN};
+};
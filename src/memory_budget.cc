@@ -0,0 +1,50 @@
+#include "memory_budget.hh"
+#include "tcp_config.hh"
+
+#include <algorithm>
+#include <utility>
+
+using namespace std;
+
+MemoryBudget::Share::Share(Share&& other) noexcept
+  : budget_(exchange(other.budget_, nullptr)), bytes_(exchange(other.bytes_, 0)) {}
+
+MemoryBudget::Share& MemoryBudget::Share::operator=(Share&& other) noexcept {
+    if (this != &other) {
+        release(bytes_);
+        budget_ = exchange(other.budget_, nullptr);
+        bytes_ = exchange(other.bytes_, 0);
+    }
+    return *this;
+}
+
+bool MemoryBudget::Share::grow(const uint64_t bytes) {
+    if (not budget_) {
+        bytes_ += bytes;
+        return true;
+    }
+
+    /* several threads' connections may draw on the same budget */
+    uint64_t used = budget_->used_.load();
+    do {
+        if (bytes > budget_->limit_ - min(used, budget_->limit_)) {
+            return false;
+        }
+    } while (not budget_->used_.compare_exchange_weak(used, used + bytes));
+
+    bytes_ += bytes;
+    return true;
+}
+
+void MemoryBudget::Share::release(const uint64_t bytes) {
+    const uint64_t released = min(bytes, bytes_);
+    if (budget_) {
+        budget_->used_ -= released;
+    }
+    bytes_ -= released;
+}
+
+MemoryBudget& MemoryBudget::receive_buffers() {
+    static MemoryBudget budget {TCPConfig::RECV_BUDGET_DFLT};
+    return budget;
+}
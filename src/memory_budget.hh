@@ -0,0 +1,41 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/* A limit on memory shared by many owners (like Linux's tcp_mem): each owner holds a Share of it, which it can
+   grow while the budget allows, and which is given back when the Share goes away. A Share of no budget can
+   grow without limit. */
+class MemoryBudget {
+  public:
+    explicit MemoryBudget(uint64_t limit) : limit_(limit) {}
+
+    class Share {
+      public:
+        explicit Share(MemoryBudget* budget = nullptr) : budget_(budget) {}
+        ~Share() { release(bytes_); }
+
+        Share(const Share& other) = delete;
+        Share& operator=(const Share& other) = delete;
+        Share(Share&& other) noexcept;
+        Share& operator=(Share&& other) noexcept;
+
+        bool grow(uint64_t bytes);    // false (and nothing taken) if the budget cannot cover `bytes` more
+        void release(uint64_t bytes); // give back up to `bytes`
+        uint64_t bytes() const { return bytes_; }
+
+      private:
+        MemoryBudget* budget_;
+        uint64_t bytes_ {};
+    };
+
+    uint64_t limit() const { return limit_; }
+    uint64_t used() const { return used_; }
+
+    /* The budget shared by all autotuned receive buffers */
+    static MemoryBudget& receive_buffers();
+
+  private:
+    uint64_t limit_;
+    std::atomic<uint64_t> used_ {};
+};
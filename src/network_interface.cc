@@ -25,6 +25,12 @@ NetworkInterface::NetworkInterface(string_view name,
 //! may also be another host if directly connected to the same network as the destination) Note: the Address type
 //! can be converted to a uint32_t (raw 32-bit IP address) by using the Address::ipv4_numeric() method.
 void NetworkInterface::send_datagram(const InternetDatagram& dgram, const Address& next_hop) {
+    send_datagram(InternetDatagram {dgram}, next_hop);
+}
+
+//! \param[in] dgram the IPv4 datagram to be sent; its payload buffers end up in the Ethernet frame
+//! \param[in] next_hop the IP address of the interface to send it to
+void NetworkInterface::send_datagram(InternetDatagram&& dgram, const Address& next_hop) {
     if (dgram.header.ttl == 0) {
         return;
     }
@@ -32,9 +38,15 @@ void NetworkInterface::send_datagram(const InternetDatagram& dgram, const Addres
     auto next_hop_ip = next_hop.ipv4_numeric();
     EthernetFrame ipv4_frame {{{}, ethernet_address_, EthernetHeader::TYPE_IPv4}};
 
+    /* only the header is serialized; the payload buffers move into the frame as they are */
     Serializer serial_ {};
-    dgram.serialize(serial_);
+    dgram.header.serialize(serial_);
     ipv4_frame.payload = serial_.output();
+    for (auto& buf : dgram.payload) {
+        if (not buf.empty()) {
+            ipv4_frame.payload.push_back(move(buf));
+        }
+    }
 
     /* ARP table hit */
     if (arp_table_.contains(next_hop_ip)) {
@@ -44,7 +56,7 @@ void NetworkInterface::send_datagram(const InternetDatagram& dgram, const Addres
     }
 
     /* store unsent frames, and wait for ARP reply */
-    frames_to_send_[next_hop_ip].push_back(ipv4_frame);
+    frames_to_send_[next_hop_ip].push_back(move(ipv4_frame));
 
     /* ARP table miss, and not requested yet */
     if (not arp_requests_sent_.contains(next_hop_ip)) {
@@ -75,7 +87,7 @@ void NetworkInterface::recv_frame(const EthernetFrame& frame) {
             return;
         }
 
-        datagrams_received_.push(ipv4_datagram);
+        datagrams_received_.push(move(ipv4_datagram));
     }
 
     /* ARP frames: reply or request */
@@ -50,6 +50,9 @@ class NetworkInterface {
     // hop. Sending is accomplished by calling `transmit()` (a member variable) on the frame.
     void send_datagram(const InternetDatagram& dgram, const Address& next_hop);
 
+    // Same as above, but moves the datagram's payload buffers into the Ethernet frame instead of copying them
+    void send_datagram(InternetDatagram&& dgram, const Address& next_hop);
+
     // Receives an Ethernet frame and responds appropriately.
     // If type is IPv4, pushes the datagram to the datagrams_in queue.
     // If type is ARP request, learn a mapping from the "sender" fields, and send an ARP reply.
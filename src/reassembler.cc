@@ -1,92 +1,236 @@
 #include "reassembler.hh"
 
+#include <bit>
+#include <cstring>
+
 using namespace std;
 
-void Reassembler::insert(uint64_t first_index, string data, bool is_last_substring) {
-    auto asize = Writer {output_}.available_capacity();
+namespace {
+/* call f(word, mask) for each bitmap word overlapping bit range [begin, end), wrapping around the bitmap */
+template<typename F>
+void for_each_word(vector<uint64_t>& bitmap, uint64_t begin, uint64_t end, F&& f) {
+    const uint64_t nbits = bitmap.size() * 64;
+    while (begin < end) {
+        const auto pos = begin % nbits;
+        const auto shift = pos % 64;
+        const auto len = min(end - begin, 64 - shift);
+        const uint64_t mask = (len == 64 ? ~uint64_t {} : (uint64_t {1} << len) - 1) << shift;
+        f(bitmap[pos / 64], mask);
+        begin += len;
+    }
+}
 
-    /* data sent before or beyond capacity, drop it */
-    if (first_index + data.size() < expected_begin_ or expected_begin_ + asize < first_index) {
-        return;
+/* how many bits from `begin` on (wrapping around the bitmap) are equal to `set`, counting at most `limit` */
+uint64_t bit_run(const vector<uint64_t>& bitmap, uint64_t begin, bool set, uint64_t limit) {
+    const uint64_t nbits = bitmap.size() * 64;
+    uint64_t run = 0;
+    while (run < limit) {
+        const auto pos = (begin + run) % nbits;
+        const uint64_t word = set ? bitmap[pos / 64] : ~bitmap[pos / 64];
+        const auto ones = static_cast<uint64_t>(countr_one(word >> (pos % 64)));
+        run += ones;
+        if (ones < 64 - pos % 64) {
+            break;
+        }
     }
+    return min(run, limit);
+}
+} // namespace
 
+Reassembler::Reassembler(ByteStream&& output, Storage storage)
+  : output_(std::move(output)), storage_type_(storage) {
+    if (storage_type_ == Storage::Bitmap) {
+        const auto capacity = output_.writer().available_capacity() + output_.reader().bytes_buffered();
+        bitmap_.resize((capacity + 63) / 64);
+    }
+}
+
+void Reassembler::insert(uint64_t first_index, string data, bool is_last_substring) {
     /* last substring, store the end position */
     if (is_last_substring) {
         last_index_ = first_index + data.size();
     }
 
-    /* cut off bytes beyond available capacity, if necessary */
-    storage_.emplace(pair {first_index, move(data).substr(0, expected_begin_ + asize - first_index)});
+    /* keep only the bytes within [expected_begin_, expected_begin_ + available capacity) */
+    const auto window_end = expected_begin_ + output_.writer().available_capacity();
+    const auto begin = max(first_index, expected_begin_);
+    const auto end = min(first_index + data.size(), window_end);
+
+    if (storage_type_ == Storage::Bitmap) {
+        /* in-order fast path: nothing is pending, so the bytes are committed without touching the bitmap */
+        if (begin == expected_begin_ and begin < end and bytes_pending_ == 0) {
+            auto& writer_ = output_.writer();
+            auto space = writer_.reserve(end - begin);
+            memcpy(space.data(), data.data() + (begin - first_index), space.size());
+            writer_.commit(space.size());
+            expected_begin_ = end;
+            if (expected_begin_ >= last_index_) {
+                writer_.close();
+            }
+            return;
+        }
+        if (begin < end) {
+            place(begin, string_view {data}.substr(begin - first_index, end - begin));
+        }
+        output_placed();
+        return;
+    }
+
+    /* in-order fast path: nothing is waiting, so the bytes go straight to the stream without being stored */
+    if (begin == expected_begin_ and begin < end and storage_.empty()) {
+        auto& writer_ = output_.writer();
+        if (begin == first_index and end == first_index + data.size()) {
+            writer_.push(move(data));
+        } else {
+            auto space = writer_.reserve(end - begin);
+            memcpy(space.data(), data.data() + (begin - first_index), space.size());
+            writer_.commit(space.size());
+        }
+        expected_begin_ = end;
+        if (expected_begin_ >= last_index_) {
+            writer_.close();
+        }
+        return;
+    }
+
+    if (begin < end) {
+        if (begin != first_index or end != first_index + data.size()) {
+            data = data.substr(begin - first_index, end - begin);
+        }
+        store(begin, move(data));
+    }
 
     /* expected bytes received, output */
-    if (storage_.top().first <= expected_begin_) {
-        output();
+    output();
+}
+
+bool Reassembler::grow_capacity(uint64_t capacity) {
+    if (storage_type_ == Storage::Bitmap and bytes_pending_ > 0) {
+        return false;
+    }
+    output_.grow_capacity(capacity);
+
+    /* with nothing pending the bitmap is all clear, so it can simply be resized */
+    if (storage_type_ == Storage::Bitmap) {
+        bitmap_.resize((output_.capacity() + 63) / 64);
     }
+    return true;
 }
 
-void Reassembler::output() {
-    Writer& writer_ = static_cast<Writer&>(output_);
+void Reassembler::place(uint64_t first_index, string_view data) {
+    /* the writer's free space starts at expected_begin_, so each byte lands where it will be delivered from */
+    auto free_space = output_.writer().reserve(output_.writer().available_capacity());
+    if (free_space.empty()) {
+        return;
+    }
+    memcpy(free_space.data() + (first_index - expected_begin_), data.data(), data.size());
 
-    while (not storage_.empty()) {
-        auto [first_index_, data_] = storage_.top();
+    for_each_word(bitmap_, first_index, first_index + data.size(), [&](uint64_t& word, uint64_t mask) {
+        bytes_pending_ += popcount(mask & ~word);
+        word |= mask;
+    });
+}
 
-        /* minimum first_index is beyond expected, break */
-        if (first_index_ > expected_begin_) {
-            break;
-        }
+void Reassembler::output_placed() {
+    /* count the run of present bytes starting at expected_begin_, a word at a time */
+    const uint64_t run = bit_run(bitmap_, expected_begin_, true, bytes_pending_);
+
+    if (run) {
+        for_each_word(bitmap_, expected_begin_, expected_begin_ + run, [](uint64_t& word, uint64_t mask) {
+            word &= ~mask;
+        });
+        output_.writer().commit(run);
+        expected_begin_ += run;
+        bytes_pending_ -= run;
+    }
 
-        storage_.pop();
+    /* last substring written, close the writer */
+    if (expected_begin_ >= last_index_) {
+        output_.writer().close();
+    }
+}
 
-        /* data sent before, skip */
-        if (expected_begin_ > first_index_ + data_.size()) {
-            continue;
-        }
+void Reassembler::store(uint64_t first_index, string data) {
+    auto last_index = first_index + data.size();
 
-        /* data should be within capacity, just push */
-        writer_.push(data_.substr(expected_begin_ - first_index_));
-        expected_begin_ += data_.size() - expected_begin_ + first_index_;
+    /* left neighbour: drop the prefix it already covers */
+    auto it = storage_.upper_bound(first_index);
+    if (it != storage_.begin()) {
+        const auto& [prev_index, prev_data] = *prev(it);
+        const auto prev_end = prev_index + prev_data.size();
+        if (prev_end >= last_index) {
+            return;
+        }
+        if (prev_end > first_index) {
+            data.erase(0, prev_end - first_index);
+            first_index = prev_end;
+        }
+    }
 
-        /* last substring, close the writer */
-        if (first_index_ + data_.size() >= last_index_) {
-            writer_.close();
+    /* right neighbours: erase the ones fully covered, drop the suffix the next one covers */
+    while (it != storage_.end() and it->first < last_index) {
+        const auto next_end = it->first + it->second.size();
+        if (next_end > last_index) {
+            data.resize(it->first - first_index);
+            last_index = it->first;
+            break;
         }
+        bytes_pending_ -= it->second.size();
+        it = storage_.erase(it);
+    }
+
+    if (not data.empty()) {
+        bytes_pending_ += data.size();
+        storage_.emplace_hint(it, first_index, move(data));
     }
 }
 
-uint64_t Reassembler::bytes_pending() const {
-    uint64_t total_bytes_stored_ {};
-    uint64_t prev_index_ {};
-    vector<IndexString> temp {};
+void Reassembler::output() {
+    Writer& writer_ = output_.writer();
 
-    /* well, just make storage queue mutable... */
-    while (not storage_.empty()) {
-        auto [first_index_, data_] = storage_.top();
-        storage_.pop();
+    while (not storage_.empty() and storage_.begin()->first == expected_begin_) {
+        auto& data_ = storage_.begin()->second;
 
-        if (prev_index_ == 0) {
-            prev_index_ = first_index_;
-        }
+        expected_begin_ += data_.size();
+        bytes_pending_ -= data_.size();
+        writer_.push(move(data_));
+        storage_.erase(storage_.begin());
+    }
 
-        /* completely covered by another byte */
-        if (first_index_ + data_.size() < prev_index_) {
-            continue;
-        }
+    /* last substring written, close the writer */
+    if (expected_begin_ >= last_index_) {
+        writer_.close();
+    }
+}
 
-        auto offset {first_index_ > prev_index_ ? 0 : prev_index_ - first_index_};
+uint64_t Reassembler::bytes_pending() const {
+    return bytes_pending_;
+}
 
-        /* beginning of storage */
-        if (first_index_ < expected_begin_) {
-            offset = expected_begin_ - first_index_;
+vector<pair<uint64_t, uint64_t>> Reassembler::pending_ranges() const {
+    vector<pair<uint64_t, uint64_t>> ranges;
+
+    if (storage_type_ == Storage::Bitmap) {
+        /* alternate runs of absent and present bits until every pending byte is accounted for */
+        uint64_t index = expected_begin_;
+        uint64_t found = 0;
+        while (found < bytes_pending_) {
+            index += bit_run(bitmap_, index, false, UINT64_MAX);
+            const auto len = bit_run(bitmap_, index, true, bytes_pending_ - found);
+            ranges.emplace_back(index, index + len);
+            index += len;
+            found += len;
         }
-
-        total_bytes_stored_ += data_.size() - offset;
-        prev_index_ = first_index_ + data_.size();
-
-        temp.push_back({first_index_, move(data_)});
+        return ranges;
     }
 
-    for (auto& IndexData : temp) {
-        storage_.emplace(move(IndexData));
+    /* stored substrings may abut each other */
+    for (const auto& [first_index, data] : storage_) {
+        if (not ranges.empty() and ranges.back().second == first_index) {
+            ranges.back().second += data.size();
+        } else {
+            ranges.emplace_back(first_index, first_index + data.size());
+        }
     }
-    return total_bytes_stored_;
+    return ranges;
 }
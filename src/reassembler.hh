@@ -2,10 +2,22 @@
 
 #include "byte_stream.hh"
 
+#include <map>
+#include <utility>
+#include <vector>
+
 class Reassembler {
   public:
+    /*
+     * How out-of-order bytes are held until the gap before them is filled:
+     *   `IntervalMap`: a map of disjoint substrings (memory proportional to the bytes pending)
+     *   `Bitmap`: bytes are copied straight to their final place in the output stream's free space,
+     *             with a presence bit per byte of capacity (no per-segment allocation)
+     */
+    enum class Storage { IntervalMap, Bitmap };
+
     // Construct Reassembler to write into given ByteStream.
-    explicit Reassembler(ByteStream&& output) : output_(std::move(output)) {}
+    explicit Reassembler(ByteStream&& output, Storage storage = Storage::IntervalMap);
 
     /*
      * Insert a new substring to be reassembled into a ByteStream.
@@ -32,6 +44,13 @@ class Reassembler {
     // How many bytes are stored in the Reassembler itself?
     uint64_t bytes_pending() const;
 
+    // The [first, last) index ranges of the bytes stored in the Reassembler, in increasing order
+    std::vector<std::pair<uint64_t, uint64_t>> pending_ranges() const;
+
+    // Raise the output stream's capacity (see ByteStream::grow_capacity). Bitmap storage places pending bytes
+    // in the stream's free space, so it can only grow while nothing is pending.
+    bool grow_capacity(uint64_t capacity);
+
     // Access output stream reader
     Reader& reader() { return output_.reader(); }
     const Reader& reader() const { return output_.reader(); }
@@ -40,13 +59,20 @@ class Reassembler {
     const Writer& writer() const { return output_.writer(); }
 
   private:
+    void store(uint64_t first_index, std::string data);
     void output();
     ByteStream output_; // the Reassembler writes to this ByteStream
+    Storage storage_type_;
+
+    /* IntervalMap storage: non-overlapping substrings keyed by first_index, all at or beyond expected_begin_ */
+    std::map<uint64_t, std::string> storage_ {};
+
+    /* Bitmap storage: one presence bit per stream index (modulo the bitmap size), set while the byte is pending */
+    std::vector<uint64_t> bitmap_ {};
+    void place(uint64_t first_index, std::string_view data);
+    void output_placed();
 
-    /* IndexString pair: <first_index, data> */
-    typedef std::pair<uint64_t, std::string> IndexString;
-    /* reassembler storage queue */
-    std::priority_queue<IndexString, std::vector<IndexString>, std::greater<>> mutable storage_ {};
+    uint64_t bytes_pending_ {};
 
     uint64_t expected_begin_ {};
     uint64_t last_index_ {std::string::npos};
@@ -22,7 +22,8 @@ void Router::add_route(const uint32_t route_prefix,
          << static_cast<int>(prefix_length) << " => " << (next_hop.has_value() ? next_hop->ip() : "(direct)")
          << " on interface " << interface_num << " with name " << _interfaces[interface_num]->name() << "\n";
 
-    forwarding_table_.push_back({route_prefix, prefix_length, interface_num, next_hop});
+    forwarding_table_.add(route_prefix, prefix_length, routes_.size());
+    routes_.emplace_back(interface_num, next_hop);
 }
 
 // Go through all the interfaces, and route every incoming datagram to its proper outgoing interface.
@@ -33,37 +34,97 @@ void Router::route() {
     for (auto& interface : _interfaces) {
         auto& datagrams = interface->datagrams_received();
         while (not datagrams.empty()) {
-            auto dgram_ = datagrams.front();
+            auto dgram_ = move(datagrams.front());
             datagrams.pop();
             if (dgram_.header.ttl == 0) {
                 continue;
             }
-            /* update TTL and checksum */
-            dgram_.header.ttl--;
-            dgram_.header.compute_checksum();
+            /* update TTL and checksum (incrementally) */
+            dgram_.header.decrement_ttl();
 
-            /* longest prefix matching */
-            uint8_t max_prefix_length {};
-            uint32_t next_hop_interface {};
-            optional<Address> next_hop_addr {};
-            for (auto& [router_prefix_, prefix_length_, num_, addr_] : forwarding_table_) {
-                if (max_prefix_length > prefix_length_) {
-                    continue;
-                }
-                if ((dgram_.header.dst ^ router_prefix_) < (1ul << (32 - prefix_length_))) {
-                    next_hop_interface = num_;
-                    next_hop_addr = addr_;
-                    max_prefix_length = prefix_length_;
-                }
+            /* longest prefix matching, drop the datagram if no route matches */
+            const auto route_ = forwarding_table_.lookup(dgram_.header.dst);
+            if (not route_.has_value()) {
+                continue;
             }
+            const auto& [next_hop_interface, next_hop_addr] = routes_[route_.value()];
             route_dgrams_.push({next_hop_interface, move(dgram_), next_hop_addr});
         }
     }
 
     while (not route_dgrams_.empty()) {
-        auto [interface_num_, dgram_, next_hop_addr_] = route_dgrams_.front();
+        auto& [interface_num_, dgram_, next_hop_addr_] = route_dgrams_.front();
+        const auto next_hop_ = next_hop_addr_.value_or(Address::from_ipv4_numeric(dgram_.header.dst));
+        _interfaces[interface_num_]->send_datagram(move(dgram_), next_hop_);
         route_dgrams_.pop();
-        _interfaces[interface_num_]->send_datagram(
-          dgram_, next_hop_addr_.value_or(Address::from_ipv4_numeric(dgram_.header.dst)));
     }
 }
+
+void ForwardingTable::add(const uint32_t route_prefix, const uint8_t prefix_length, const uint32_t route) {
+    /* walk (creating as needed) down to the level whose stride contains the prefix's last bit */
+    size_t node = 0;
+    unsigned shift = 32 - STRIDE;
+    unsigned consumed = 0;
+    while (prefix_length > consumed + STRIDE) {
+        const unsigned slot = (route_prefix >> shift) & (FANOUT - 1);
+        const int32_t entry = nodes_[node].slots[slot];
+        if (entry < 0) {
+            node = -entry;
+        } else {
+            /* the route that covered this slot moves to the new child */
+            const uint8_t length = nodes_[node].lengths[slot];
+            nodes_.emplace_back();
+            nodes_.back().parent_route = entry;
+            nodes_.back().parent_length = length;
+            nodes_[node].slots[slot] = -static_cast<int32_t>(nodes_.size() - 1);
+            node = nodes_.size() - 1;
+        }
+        shift -= STRIDE;
+        consumed += STRIDE;
+    }
+
+    /* the prefix covers a run of 2^(unused bits) slots in this node */
+    const unsigned bits = prefix_length - consumed;
+    const unsigned first_slot = ((route_prefix >> shift) & (FANOUT - 1)) & ~((FANOUT - 1) >> bits);
+    const auto value = static_cast<int32_t>(route + 1);
+    for (unsigned slot = first_slot; slot < first_slot + (FANOUT >> bits); ++slot) {
+        auto& current = nodes_[node];
+        if (current.slots[slot] < 0) {
+            auto& child = nodes_[-current.slots[slot]];
+            set_if_longer(child.parent_route, child.parent_length, value, prefix_length);
+        } else {
+            set_if_longer(current.slots[slot], current.lengths[slot], value, prefix_length);
+        }
+    }
+}
+
+// Slots only ever hold prefixes ending in the same stride, so equal-or-longer wins
+void ForwardingTable::set_if_longer(int32_t& route,
+                                    uint8_t& length,
+                                    const int32_t new_route,
+                                    const uint8_t new_length) {
+    if (route == 0 or length <= new_length) {
+        route = new_route;
+        length = new_length;
+    }
+}
+
+optional<uint32_t> ForwardingTable::lookup(const uint32_t address) const {
+    /* deeper levels hold longer prefixes, so the last route seen on the way down is the longest match */
+    int32_t best = 0;
+    size_t node = 0;
+    for (unsigned shift = 32 - STRIDE;; shift -= STRIDE) {
+        const int32_t entry = nodes_[node].slots[(address >> shift) & (FANOUT - 1)];
+        if (entry >= 0) {
+            best = entry ? entry : best;
+            break;
+        }
+        node = -entry;
+        best = nodes_[node].parent_route ? nodes_[node].parent_route : best;
+    }
+
+    if (best == 0) {
+        return {};
+    }
+    return best - 1;
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <memory>
 #include <optional>
 #include <tuple>
@@ -9,6 +10,37 @@
 #include "exception.hh"
 #include "network_interface.hh"
 
+// \brief A longest-prefix-match table from IPv4 prefixes to route numbers.
+// A multibit trie with 8-bit strides: each prefix is expanded over the slots of the one node whose stride
+// holds its last bit, so a lookup is at most four array reads whatever the number of routes.
+class ForwardingTable {
+  public:
+    // Add a route; among routes with equal prefixes, the one added last wins
+    void add(uint32_t route_prefix, uint8_t prefix_length, uint32_t route);
+
+    // The route whose prefix is the longest match for `address`, if any
+    std::optional<uint32_t> lookup(uint32_t address) const;
+
+    // Bytes used by the trie nodes
+    size_t memory_usage() const { return nodes_.capacity() * sizeof(Node); }
+
+  private:
+    static constexpr unsigned STRIDE = 8;
+    static constexpr unsigned FANOUT = 1 << STRIDE;
+
+    /* route encoding: 0 = no route, > 0 = route + 1; a slot < 0 points to child node -slot instead */
+    struct Node {
+        std::array<int32_t, FANOUT> slots {};
+        std::array<uint8_t, FANOUT> lengths {}; // prefix length of the route in each slot
+        int32_t parent_route {};                // route of the parent's slot that now points here
+        uint8_t parent_length {};
+    };
+
+    static void set_if_longer(int32_t& route, uint8_t& length, int32_t new_route, uint8_t new_length);
+
+    std::vector<Node> nodes_ {1};
+};
+
 // \brief A router that has multiple network interfaces and
 // performs longest-prefix-match routing between them.
 class Router {
@@ -37,6 +69,7 @@ class Router {
     // The router's collection of network interfaces
     std::vector<std::shared_ptr<NetworkInterface>> _interfaces {};
 
-    /* The router's forwarding table */
-    std::vector<std::tuple<uint32_t, uint8_t, size_t, std::optional<Address>>> forwarding_table_ {};
+    /* The router's routes <interface_num, next_hop>, indexed by the forwarding table */
+    std::vector<std::pair<size_t, std::optional<Address>>> routes_ {};
+    ForwardingTable forwarding_table_ {};
 };
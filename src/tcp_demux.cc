@@ -0,0 +1,489 @@
+#include "tcp_demux.hh"
+
+#include "ipv4_datagram.hh"
+#include "ipv4_header.hh"
+#include "parser.hh"
+#include "random.hh"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <random>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+namespace {
+// the MurmurHash3 avalanche: every input bit affects every output bit
+uint64_t mix(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccd;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53;
+    x ^= x >> 33;
+    return x;
+}
+
+uint64_t random_u64() {
+    random_device rd;
+    return (uint64_t {rd()} << 32) | rd();
+}
+
+class Wrap32Raw : public Wrap32 {
+  public:
+    uint32_t raw_value() const { return raw_value_; }
+};
+
+uint32_t raw(Wrap32 seqno) {
+    return Wrap32Raw {seqno}.raw_value();
+}
+
+Address address(uint32_t ipv4_numeric, uint16_t port) {
+    return Address {Address::from_ipv4_numeric(ipv4_numeric).ip(), port};
+}
+} // namespace
+
+ConnectionTable::ConnectionTable(size_t expected_connections)
+  : slots_(bit_ceil(max(MIN_SLOTS, expected_connections + expected_connections / 3 + 1)))
+  , seed_(random_u64()) {}
+
+size_t ConnectionTable::home(const FourTuple& key) const {
+    // fold the 96 bits into 64 with the seed, then avalanche
+    uint64_t x = (uint64_t {key.remote_address} << 32 | key.local_address) ^ seed_;
+    x ^= (uint64_t {key.remote_port} << 16 | key.local_port) * 0x9e3779b97f4a7c15;
+    return mix(x) & (slots_.size() - 1);
+}
+
+optional<size_t> ConnectionTable::locate(const FourTuple& key) const {
+    const size_t mask = slots_.size() - 1;
+    for (size_t i = home(key); slots_[i].connection != EMPTY; i = (i + 1) & mask) {
+        if (slots_[i].key == key) {
+            return i;
+        }
+    }
+    return {};
+}
+
+bool ConnectionTable::insert(const FourTuple& key, uint32_t connection) {
+    if (connection == EMPTY) {
+        throw runtime_error("ConnectionTable: connection number out of range");
+    }
+    if (locate(key).has_value()) {
+        return false;
+    }
+
+    // keep the load at most 3/4 so that a probe soon reaches a free slot
+    if (4 * (size_ + 1) > 3 * slots_.size()) {
+        grow();
+    }
+
+    const size_t mask = slots_.size() - 1;
+    size_t i = home(key);
+    while (slots_[i].connection != EMPTY) {
+        i = (i + 1) & mask;
+    }
+    slots_[i] = {key, connection};
+    ++size_;
+    return true;
+}
+
+optional<uint32_t> ConnectionTable::find(const FourTuple& key) const {
+    const auto i = locate(key);
+    if (not i.has_value()) {
+        return {};
+    }
+    return slots_[i.value()].connection;
+}
+
+bool ConnectionTable::erase(const FourTuple& key) {
+    const auto found = locate(key);
+    if (not found.has_value()) {
+        return false;
+    }
+
+    // move each later entry of the run back into the hole, unless that would put it before its home slot
+    const size_t mask = slots_.size() - 1;
+    size_t hole = found.value();
+    for (size_t i = (hole + 1) & mask; slots_[i].connection != EMPTY; i = (i + 1) & mask) {
+        const size_t distance_from_home = (i - home(slots_[i].key)) & mask;
+        if (distance_from_home >= ((i - hole) & mask)) {
+            slots_[hole] = slots_[i];
+            hole = i;
+        }
+    }
+    slots_[hole] = {};
+    --size_;
+    return true;
+}
+
+void ConnectionTable::grow() {
+    vector<Slot> old(slots_.size() * 2);
+    swap(old, slots_);
+
+    const size_t mask = slots_.size() - 1;
+    for (const auto& slot : old) {
+        if (slot.connection != EMPTY) {
+            size_t i = home(slot.key);
+            while (slots_[i].connection != EMPTY) {
+                i = (i + 1) & mask;
+            }
+            slots_[i] = slot;
+        }
+    }
+}
+
+TCPOverIPv4Demultiplexer::TCPOverIPv4Demultiplexer(TunFD&& tun, size_t expected_connections)
+  : mtu_(tun.mtu())
+  , checksum_offload_(tun.checksum_offload())
+  , fd_(move(tun))
+  , table_(expected_connections)
+  , rng_(get_random_engine())
+  , cookie_secret_(random_u64()) {
+    connections_.reserve(expected_connections);
+}
+
+TCPOverIPv4Demultiplexer::TCPOverIPv4Demultiplexer(FileDescriptor&& fd, size_t mtu, size_t expected_connections)
+  : mtu_(mtu)
+  , fd_(move(fd))
+  , table_(expected_connections)
+  , rng_(get_random_engine())
+  , cookie_secret_(random_u64()) {
+    connections_.reserve(expected_connections);
+}
+
+size_t TCPOverIPv4Demultiplexer::connect(const TCPConfig& tcp_config,
+                                         const FdAdapterConfig& adapter_config,
+                                         string first_data) {
+    const size_t number = open(tcp_config, adapter_config);
+    auto& peer = connections_[number]->peer;
+    if (tcp_config.fast_open) {
+        peer.enable_fast_open(FastOpenCookies::cached(adapter_config.destination.ipv4_numeric()));
+    } else {
+        push(number); // the SYN goes out alone, and the data waits for the handshake
+    }
+    peer.outbound_writer().push(move(first_data));
+    push(number);
+    return number;
+}
+
+size_t TCPOverIPv4Demultiplexer::open(const TCPConfig& tcp_config, const FdAdapterConfig& adapter_config) {
+    size_t number = connections_.size();
+    if (not free_numbers_.empty()) {
+        number = free_numbers_.back();
+    }
+
+    if (not table_.insert(four_tuple(adapter_config), number)) {
+        throw runtime_error("TCPOverIPv4Demultiplexer: connection to " + adapter_config.destination.to_string()
+                            + " from " + adapter_config.source.to_string() + " already exists");
+    }
+
+    auto connection = make_unique<Connection>(tcp_config);
+    connection->adapter.config_mut() = adapter_config;
+    connection->adapter.set_mtu(mtu_);
+    if (number == connections_.size()) {
+        connections_.push_back(move(connection));
+    } else {
+        free_numbers_.pop_back();
+        connections_[number] = move(connection);
+    }
+    return number;
+}
+
+void TCPOverIPv4Demultiplexer::push(size_t connection) {
+    auto& pushed = at(connection);
+    pushed.peer.push([&](const TCPMessage& msg) { write(pushed, msg); });
+}
+
+void TCPOverIPv4Demultiplexer::erase(size_t connection) {
+    const auto& erased = at(connection);
+    if (erased.listener.has_value()) {
+        auto& listener = listeners_[erased.listener.value()];
+        if (erased.established) {
+            std::erase(listener.accept_queue, connection);
+        } else {
+            --listener.half_open;
+        }
+    }
+
+    table_.erase(four_tuple(erased.adapter.config()));
+    connections_[connection].reset();
+    free_numbers_.push_back(connection);
+}
+
+optional<size_t> TCPOverIPv4Demultiplexer::read() {
+    vector<string> buffers(2);
+    buffers.front().resize(IPv4Header::LENGTH);
+    const bool checksum_verified = TunTapFD::read_datagram(fd_, checksum_offload_, buffers);
+    return receive(buffers, checksum_verified);
+}
+
+optional<size_t> TCPOverIPv4Demultiplexer::receive(const vector<string>& datagram, bool checksum_verified) {
+    const auto key = four_tuple(datagram);
+    if (not key.has_value()) {
+        return {};
+    }
+    const auto number = table_.find(key.value());
+    if (not number.has_value()) {
+        return listener_receive(key.value(), datagram, checksum_verified);
+    }
+
+    // a half-open connection may not complete while the accept queue is full; it will retransmit its SYN-ACK
+    auto& connection = *connections_[number.value()];
+    if (connection.listener.has_value() and not connection.established) {
+        const auto& listener = listeners_[connection.listener.value()];
+        if (listener.accept_queue.size() >= listener.config.backlog) {
+            return {};
+        }
+    }
+
+    // only now parse (and checksum) the whole datagram, with the state of the connection it belongs to
+    InternetDatagram ip_dgram;
+    if (not parse(ip_dgram, datagram)) {
+        return {};
+    }
+    if (auto msg = connection.adapter.unwrap_tcp_in_ip(ip_dgram, checksum_verified)) {
+        connection.peer.receive(move(msg.value()), [&](const TCPMessage& x) { write(connection, x); });
+        check_established(number.value());
+    }
+    return number;
+}
+
+void TCPOverIPv4Demultiplexer::tick(uint64_t ms_since_last_tick) {
+    now_ms_ += ms_since_last_tick;
+    for (size_t number = 0; number < connections_.size(); ++number) {
+        auto& connection = connections_[number];
+        if (not connection) {
+            continue;
+        }
+        if (connection->peer.active()) {
+            connection->peer.tick(ms_since_last_tick, [&](const TCPMessage& x) { write(*connection, x); });
+        }
+
+        const bool half_open = connection->listener.has_value() and not connection->established;
+        if (half_open
+            and (not connection->peer.active()
+                 or connection->peer.sender().consecutive_retransmissions() > SYN_ACK_RETRIES)) {
+            erase(number);
+        }
+    }
+}
+
+size_t TCPOverIPv4Demultiplexer::listen(const TCPConfig& tcp_config, const ListenerConfig& listener_config) {
+    for (const auto& listener : listeners_) {
+        if (listener.config.local.port() == listener_config.local.port()
+            and (listener.config.local.ipv4_numeric() == listener_config.local.ipv4_numeric()
+                 or listener.config.local.ipv4_numeric() == 0 or listener_config.local.ipv4_numeric() == 0)) {
+            throw runtime_error("TCPOverIPv4Demultiplexer: already listening on "
+                                + listener_config.local.to_string());
+        }
+    }
+    listeners_.push_back({.tcp_config = tcp_config, .config = listener_config});
+    return listeners_.size() - 1;
+}
+
+optional<size_t> TCPOverIPv4Demultiplexer::accept(size_t listener) {
+    auto& accept_queue = listeners_.at(listener).accept_queue;
+    if (accept_queue.empty()) {
+        return {};
+    }
+    const uint32_t number = accept_queue.front();
+    accept_queue.pop_front();
+    connections_[number]->listener.reset();
+    return number;
+}
+
+optional<size_t> TCPOverIPv4Demultiplexer::listener_receive(const FourTuple& key,
+                                                            const vector<string>& datagram,
+                                                            bool checksum_verified) {
+    const auto it = ranges::find_if(listeners_, [&](const Listener& listener) {
+        const auto local_address = listener.config.local.ipv4_numeric();
+        return listener.config.local.port() == key.local_port
+               and (local_address == 0 or local_address == key.local_address);
+    });
+    if (it == listeners_.end()) {
+        return {};
+    }
+    auto& listener = *it;
+    const size_t listener_number = it - listeners_.begin();
+
+    // parse with the adapter of the connection this may become, so it records the options of the peer's SYN
+    InternetDatagram ip_dgram;
+    if (not parse(ip_dgram, datagram)) {
+        return {};
+    }
+    FdAdapterConfig adapter_config;
+    adapter_config.source = address(key.local_address, key.local_port);
+    adapter_config.destination = address(key.remote_address, key.remote_port);
+    TCPOverIPv4Adapter adapter;
+    adapter.config_mut() = adapter_config;
+    adapter.set_mtu(mtu_);
+    adapter.set_fast_open(listener.tcp_config.fast_open);
+    auto msg = adapter.unwrap_tcp_in_ip(ip_dgram, checksum_verified);
+    if (not msg.has_value() or msg->sender.RST) {
+        return {};
+    }
+
+    // a SYN that could not complete (the accept queue is full) is dropped, to be retransmitted
+    const bool syn = msg->sender.SYN and not msg->receiver.ackno.has_value();
+    if (syn and listener.accept_queue.size() >= listener.config.backlog) {
+        return {};
+    }
+
+    optional<TCPMessage> cookie_syn;
+    if (syn and listener.half_open >= listener.config.syn_backlog) {
+        if (listener.config.syn_cookies) {
+            // answer without keeping state, offering neither window scaling nor SACK, which a cookie cannot hold
+            const auto mss = msg->receiver.max_segment_size.value_or(COOKIE_MSS.front());
+            const auto cookie = syn_cookie(key, raw(msg->sender.seqno), mss, now_ms_ / COOKIE_PERIOD_MS);
+            TCPMessage syn_ack;
+            syn_ack.sender.SYN = true;
+            syn_ack.sender.seqno = Wrap32 {cookie};
+            syn_ack.receiver.ackno = msg->sender.seqno + 1;
+            syn_ack.receiver.window_size = min<size_t>(listener.tcp_config.recv_capacity, UINT16_MAX);
+            syn_ack.receiver.max_segment_size = listener.tcp_config.mss;
+            TunTapFD::write_datagram(fd_, checksum_offload_, adapter.serialize_tcp_in_ip(syn_ack));
+        }
+        return {};
+    }
+
+    if (not syn) {
+        // the ACK of a cookie SYN-ACK stands for the SYN it answered, if the accept queue has room for it
+        if (not listener.config.syn_cookies or msg->sender.SYN or not msg->receiver.ackno.has_value()
+            or listener.accept_queue.size() >= listener.config.backlog) {
+            return {};
+        }
+        const uint32_t client_isn = raw(msg->sender.seqno) - 1;
+        const uint32_t cookie = raw(msg->receiver.ackno.value()) - 1;
+        const auto mss = check_syn_cookie(key, client_isn, cookie);
+        if (not mss.has_value()) {
+            return {};
+        }
+        cookie_syn.emplace();
+        cookie_syn->sender.SYN = true;
+        cookie_syn->sender.seqno = Wrap32 {client_isn};
+        cookie_syn->receiver.window_size = msg->receiver.window_size;
+        cookie_syn->receiver.max_segment_size = mss;
+    }
+
+    TCPConfig tcp_config = listener.tcp_config;
+    tcp_config.isn = cookie_syn.has_value() ? msg->receiver.ackno.value() + UINT32_MAX
+                                            : Wrap32 {static_cast<uint32_t>(rng_())};
+    const size_t number = open(tcp_config, adapter_config);
+    auto& connection = *connections_[number];
+    connection.adapter = move(adapter);
+    connection.listener = listener_number;
+    if (listener.tcp_config.fast_open) {
+        connection.peer.enable_fast_open({});
+    }
+    ++listener.half_open;
+
+    // the SYN-ACK that replaying a cookie's SYN provokes went out already, as the cookie
+    if (cookie_syn.has_value()) {
+        connection.peer.receive(move(cookie_syn.value()), [](const TCPMessage&) {});
+    }
+    connection.peer.receive(move(msg.value()), [&](const TCPMessage& x) { write(connection, x); });
+    check_established(number);
+    return number;
+}
+
+void TCPOverIPv4Demultiplexer::check_established(size_t connection) {
+    auto& checked = *connections_[connection];
+    if (not checked.listener.has_value() or checked.established or not checked.peer.active()
+        or not checked.peer.has_ackno()) {
+        return;
+    }
+
+    // with Fast Open, the data on a SYN with a valid cookie may be read before the handshake completes
+    auto& listener = listeners_[checked.listener.value()];
+    const bool syn_data = listener.tcp_config.fast_open and checked.peer.inbound_reader().bytes_buffered() > 0;
+    if (checked.peer.sender().sequence_numbers_in_flight() > 0 and not syn_data) {
+        return;
+    }
+
+    checked.established = true;
+    --listener.half_open;
+    listener.accept_queue.push_back(connection);
+}
+
+uint32_t TCPOverIPv4Demultiplexer::syn_cookie(const FourTuple& key,
+                                              uint32_t client_isn,
+                                              uint16_t mss,
+                                              uint64_t period) const {
+    // 6 bits of the period, 2 of the MSS (rounded down to one a cookie can encode), 24 of keyed hash over both,
+    // so that a peer cannot pick another MSS by changing its bits
+    const auto fits = ranges::count_if(COOKIE_MSS, [&](uint16_t x) { return x <= mss; });
+    const uint32_t mss_index = fits > 0 ? fits - 1 : 0;
+    uint64_t x = mix((uint64_t {key.remote_address} << 32 | key.local_address) ^ cookie_secret_);
+    x = mix(x ^ (uint64_t {key.remote_port} << 48 | uint64_t {key.local_port} << 32 | client_isn));
+    x = mix(x ^ (period << 2 | mss_index));
+    return static_cast<uint32_t>((period & 0x3f) << 26 | mss_index << 24 | (x & 0xffffff));
+}
+
+optional<uint16_t> TCPOverIPv4Demultiplexer::check_syn_cookie(const FourTuple& key,
+                                                              uint32_t client_isn,
+                                                              uint32_t cookie) const {
+    const uint16_t mss = COOKIE_MSS.at(cookie >> 24 & 3);
+    const uint64_t period = now_ms_ / COOKIE_PERIOD_MS;
+    for (const uint64_t issued : {period, period - 1}) {
+        if (issued <= period and syn_cookie(key, client_isn, mss, issued) == cookie) {
+            return mss;
+        }
+    }
+    return {};
+}
+
+optional<FourTuple> TCPOverIPv4Demultiplexer::four_tuple(const vector<string>& datagram) {
+    // gather the IPv4 header and the TCP ports, wherever the buffer boundaries fall
+    constexpr size_t needed = IPv4Header::LENGTH + 4;
+    array<uint8_t, needed> bytes {};
+    size_t gathered = 0;
+    for (const auto& buffer : datagram) {
+        const size_t n = min(buffer.size(), needed - gathered);
+        copy_n(buffer.begin(), n, bytes.begin() + gathered);
+        gathered += n;
+        if (gathered == needed) {
+            break;
+        }
+    }
+
+    // IPv4 without options (the only kind IPv4Header parses), carrying TCP
+    if (gathered < needed or bytes[0] != 0x45 or bytes[9] != IPv4Header::PROTO_TCP) {
+        return {};
+    }
+
+    const auto be32 = [&](size_t i) {
+        return uint32_t {bytes[i]} << 24 | uint32_t {bytes[i + 1]} << 16 | uint32_t {bytes[i + 2]} << 8
+               | bytes[i + 3];
+    };
+    const auto be16 = [&](size_t i) { return static_cast<uint16_t>(bytes[i] << 8 | bytes[i + 1]); };
+    return FourTuple {.local_address = be32(16),
+                      .remote_address = be32(12),
+                      .local_port = be16(IPv4Header::LENGTH + 2),
+                      .remote_port = be16(IPv4Header::LENGTH)};
+}
+
+FourTuple TCPOverIPv4Demultiplexer::four_tuple(const FdAdapterConfig& adapter_config) {
+    return {.local_address = adapter_config.source.ipv4_numeric(),
+            .remote_address = adapter_config.destination.ipv4_numeric(),
+            .local_port = adapter_config.source.port(),
+            .remote_port = adapter_config.destination.port()};
+}
+
+TCPOverIPv4Demultiplexer::Connection& TCPOverIPv4Demultiplexer::at(size_t connection) {
+    if (connection >= connections_.size() or not connections_[connection]) {
+        throw out_of_range("TCPOverIPv4Demultiplexer: no connection " + to_string(connection));
+    }
+    return *connections_[connection];
+}
+
+const TCPOverIPv4Demultiplexer::Connection& TCPOverIPv4Demultiplexer::at(size_t connection) const {
+    if (connection >= connections_.size() or not connections_[connection]) {
+        throw out_of_range("TCPOverIPv4Demultiplexer: no connection " + to_string(connection));
+    }
+    return *connections_[connection];
+}
+
+void TCPOverIPv4Demultiplexer::write(Connection& connection, const TCPMessage& msg) {
+    TunTapFD::write_datagram(fd_, checksum_offload_, connection.adapter.serialize_tcp_in_ip(msg));
+}
@@ -1,5 +1,7 @@
 #include "tcp_receiver.hh"
 
+#include <algorithm>
+
 using namespace std;
 
 void TCPReceiver::receive(TCPSenderMessage message) {
@@ -17,23 +19,113 @@ void TCPReceiver::receive(TCPSenderMessage message) {
             return;
         }
         zero_point_.emplace(message.seqno);
+        SACK_permitted_ = message.SACK_permitted;
+    }
+
+    const auto first_index = message.seqno.unwrap(zero_point_.value() + !message.SYN, writer().bytes_pushed());
+    const bool has_payload = not message.payload.empty();
+    reassembler_.insert(first_index, move(message.payload), message.FIN);
+    if (has_payload and first_index > writer().bytes_pushed()) {
+        last_stored_index_ = first_index;
+    }
+
+    if (max_capacity_.has_value()) {
+        measure_RTT();
+    }
+}
+
+void TCPReceiver::enable_autotuning(uint64_t max_capacity, MemoryBudget* budget) {
+    max_capacity_ = max(max_capacity, capacity());
+    budget_share_ = MemoryBudget::Share {budget};
+    target_capacity_ = capacity();
+    window_scale_ = window_scale_for(max_capacity_.value());
+}
+
+void TCPReceiver::tick(uint64_t ms_since_last_tick) {
+    now_ms_ += ms_since_last_tick;
+    if (max_capacity_.has_value() and RTT_ms_.has_value()) {
+        autotune();
+    }
+}
+
+void TCPReceiver::measure_RTT() {
+    const uint64_t received = writer().bytes_pushed();
+    if (RTT_edge_.has_value() and received >= RTT_edge_.value()) {
+        /* a lower sample is taken at once, a higher one only gradually */
+        const uint64_t sample = max<uint64_t>(now_ms_ - RTT_start_ms_, 1);
+        const bool higher = RTT_ms_.has_value() and sample > RTT_ms_.value();
+        RTT_ms_ = higher ? RTT_ms_.value() + (sample - RTT_ms_.value()) / 8 : sample;
+        RTT_edge_.reset();
+    }
+
+    if (not RTT_edge_.has_value() and writer().available_capacity() > 0) {
+        RTT_edge_ = received + writer().available_capacity();
+        RTT_start_ms_ = now_ms_;
+    }
+}
+
+void TCPReceiver::autotune() {
+    if (now_ms_ - round_start_ms_ >= RTT_ms_.value()) {
+        const uint64_t read = reader().bytes_popped() - popped_at_round_start_;
+        target_capacity_ = max(target_capacity_, min(2 * read, max_capacity_.value()));
+        round_start_ms_ = now_ms_;
+        popped_at_round_start_ = reader().bytes_popped();
     }
 
-    reassembler_.insert(message.seqno.unwrap(zero_point_.value() + !message.SYN, writer().bytes_pushed()),
-                        move(message.payload),
-                        message.FIN);
+    /* the budget may not cover it, and the reassembler may have to deliver its pending bytes first; try again on
+       the next tick */
+    const uint64_t capacity = this->capacity();
+    if (target_capacity_ > capacity and budget_share_.grow(target_capacity_ - capacity)
+        and not reassembler_.grow_capacity(target_capacity_)) {
+        budget_share_.release(target_capacity_ - capacity);
+    }
 }
 
 TCPReceiverMessage TCPReceiver::send() const {
-    auto writer_ = this->writer();
+    const auto& writer_ = this->writer();
 
     auto ackno_ = zero_point_.has_value()
                     ? optional {Wrap32::wrap(writer_.bytes_pushed() + 1 + writer_.is_closed(), zero_point_.value())}
                     : nullopt;
 
-    /* window size */
-    uint16_t wnd_size_ = writer_.available_capacity() > UINT16_MAX
-                           ? static_cast<uint16_t>(UINT16_MAX)
-                           : static_cast<uint16_t>(writer_.available_capacity());
-    return {ackno_, wnd_size_, writer_.has_error()};
+    /* window size, in units of 2^window_scale_ (rounded down, so never more than the capacity left) */
+    const auto wnd_size_
+      = static_cast<uint16_t>(min<uint64_t>(writer_.available_capacity() >> window_scale_, UINT16_MAX));
+    TCPReceiverMessage msg {ackno_, wnd_size_, writer_.has_error()};
+    msg.window_scale = window_scale_;
+    msg.max_segment_size = max_segment_size_;
+    if (SACK_permitted_ and reassembler_.bytes_pending() > 0) {
+        add_sack_blocks(msg);
+    }
+    return msg;
+}
+
+uint8_t TCPReceiver::window_scale_for(uint64_t capacity) {
+    uint8_t shift = 0;
+    while (shift < TCPReceiverMessage::MAX_WINDOW_SCALE and (capacity >> shift) > UINT16_MAX) {
+        ++shift;
+    }
+    return shift;
+}
+
+void TCPReceiver::add_sack_blocks(TCPReceiverMessage& msg) const {
+    auto ranges = reassembler_.pending_ranges();
+
+    /* the block with the latest segment goes first (RFC 2018 4), then the rest from the highest down */
+    const auto latest = find_if(ranges.begin(), ranges.end(), [&](const auto& range) {
+        return range.first <= last_stored_index_ and last_stored_index_ < range.second;
+    });
+    if (latest != ranges.end()) {
+        rotate(latest, latest + 1, ranges.end());
+    }
+    reverse(ranges.begin(), ranges.end());
+
+    /* stream index i is absolute sequence number i + 1 (after the SYN) */
+    for (const auto& [first, last] : ranges) {
+        if (msg.sack_blocks.size() == TCPReceiverMessage::MAX_SACK_BLOCKS) {
+            break;
+        }
+        msg.sack_blocks.push_back({Wrap32::wrap(first + 1, zero_point_.value()),
+                                   Wrap32::wrap(last + 1, zero_point_.value())});
+    }
 }
@@ -1,13 +1,18 @@
 #pragma once
 
+#include "memory_budget.hh"
 #include "reassembler.hh"
+#include "tcp_config.hh"
 #include "tcp_receiver_message.hh"
 #include "tcp_sender_message.hh"
 
 class TCPReceiver {
   public:
-    // Construct with given Reassembler
-    explicit TCPReceiver(Reassembler&& reassembler) : reassembler_(std::move(reassembler)) {}
+    // Construct with given Reassembler, advertising that it accepts segments of up to `max_segment_size` bytes
+    explicit TCPReceiver(Reassembler&& reassembler, uint16_t max_segment_size = TCPConfig::MAX_PAYLOAD_SIZE)
+      : reassembler_(std::move(reassembler))
+      , window_scale_(window_scale_for(writer().available_capacity() + reader().bytes_buffered()))
+      , max_segment_size_(max_segment_size) {}
 
     /*
      * The TCPReceiver receives TCPSenderMessages, inserting their payload into the Reassembler
@@ -15,16 +20,55 @@ class TCPReceiver {
      */
     void receive(TCPSenderMessage message);
 
-    // The TCPReceiver sends TCPReceiverMessages to the peer's TCPSender.
+    /*
+     * The TCPReceiver sends TCPReceiverMessages to the peer's TCPSender. If the peer's SYN permitted it,
+     * these report what the Reassembler holds beyond the ackno as SACK blocks. The window is scaled so
+     * that the whole capacity can be advertised.
+     */
     TCPReceiverMessage send() const;
 
+    /*
+     * Receive-buffer autotuning (dynamic right-sizing, as in Linux): start with the Reassembler's capacity and
+     * grow it up to `max_capacity` as the application reads faster, drawing the growth from `budget`.
+     * Call this before the peer's SYN arrives, so that the window scale covers the largest capacity.
+     */
+    void enable_autotuning(uint64_t max_capacity, MemoryBudget* budget = &MemoryBudget::receive_buffers());
+
+    /* Time has passed by the given # of milliseconds since the last time the tick() method was called */
+    void tick(uint64_t ms_since_last_tick);
+
     // Access the output (only Reader is accessible non-const)
     const Reassembler& reassembler() const { return reassembler_; }
     Reader& reader() { return reassembler_.reader(); }
     const Reader& reader() const { return reassembler_.reader(); }
     const Writer& writer() const { return reassembler_.writer(); }
+    uint64_t capacity() const { return writer().capacity(); }
 
   private:
     Reassembler reassembler_;
     std::optional<Wrap32> zero_point_ {};
+
+    /* the smallest shift that lets the 16-bit window field cover `capacity` */
+    static uint8_t window_scale_for(uint64_t capacity);
+    uint8_t window_scale_;
+    uint16_t max_segment_size_;
+
+    void add_sack_blocks(TCPReceiverMessage& msg) const;
+    bool SACK_permitted_ {};
+    uint64_t last_stored_index_ {}; // first stream index of the latest segment that arrived out of order
+
+    /* autotuning: the RTT is estimated as the time the sender takes to reach the right edge of a window it was
+       offered (an upper bound, as Linux does without timestamps). Each RTT, the capacity grows to twice what
+       the application read in it, so that the window stays ahead of a sender that is limited by it. */
+    void measure_RTT();
+    void autotune();
+    std::optional<uint64_t> max_capacity_ {};
+    MemoryBudget::Share budget_share_ {};
+    uint64_t target_capacity_ {};
+    uint64_t now_ms_ {};
+    std::optional<uint64_t> RTT_ms_ {};
+    std::optional<uint64_t> RTT_edge_ {}; // stream index whose arrival ends the current measurement
+    uint64_t RTT_start_ms_ {};
+    uint64_t round_start_ms_ {};
+    uint64_t popped_at_round_start_ {};
 };
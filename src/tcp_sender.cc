@@ -1,6 +1,10 @@
 #include "tcp_sender.hh"
 #include "tcp_config.hh"
 
+#include <algorithm>
+#include <cmath>
+#include <ranges>
+
 using namespace std;
 
 uint64_t TCPSender::sequence_numbers_in_flight() const {
@@ -11,20 +15,97 @@ uint64_t TCPSender::consecutive_retransmissions() const {
     return retransmission_cnt_;
 }
 
+uint64_t TCPSender::bytes_in_pipe() const {
+    const uint64_t left_network = sacked_bytes_ + lost_bytes_ + recovery_inflation_;
+    return sequence_numbers_in_flight() - min(sequence_numbers_in_flight(), left_network);
+}
+
+uint64_t TCPSender::congestion_window_room() const {
+    if (not congestion_control_) {
+        return UINT64_MAX;
+    }
+    const uint64_t cwnd = congestion_control_->congestion_window();
+    return cwnd > bytes_in_pipe() ? cwnd - bytes_in_pipe() : 0;
+}
+
+void TCPSender::mark_lost(OutstandingSegment& segment) {
+    if (not segment.sacked and not segment.lost) {
+        segment.lost = true;
+        lost_bytes_ += segment.length;
+    }
+}
+
+TCPSenderMessage TCPSender::make_message(const OutstandingSegment& segment) const {
+    const uint64_t first_index = segment.seqno + segment.SYN - 1;
+    const auto payload = reader().retained(first_index, segment.length - segment.SYN - segment.FIN);
+    return {Wrap32::wrap(segment.seqno, isn_),
+            segment.SYN,
+            string {payload},
+            segment.FIN,
+            writer().has_error(),
+            segment.SYN,
+            segment.SYN ? fast_open_cookie_ : nullopt};
+}
+
+void TCPSender::retransmit(OutstandingSegment& segment, const TransmitFunction& transmit) {
+    transmit(make_message(segment));
+    spend_pacing_tokens(segment.length);
+    segment.retransmitted = true;
+    if (segment.lost) {
+        segment.lost = false;
+        lost_bytes_ -= segment.length;
+    }
+}
+
+void TCPSender::retransmit_lost(const TransmitFunction& transmit) {
+    /* as RFC 6675's NextSeg, look only at lost segments: one in the pipe or SACKed must not hold them back */
+    for (auto& segment : sending_bytes_) {
+        if (lost_bytes_ == 0) {
+            return;
+        }
+        if (not segment.lost) {
+            continue;
+        }
+        if (congestion_window_room() < segment.length) {
+            return;
+        }
+        retransmit(segment, transmit);
+    }
+}
+
 void TCPSender::push(const TransmitFunction& transmit) {
     auto& reader_ = static_cast<Reader&>(this->input_);
 
-    /* send as much as possible */
+    /* resend what duplicate ACKs, the SACK scoreboard or a timeout marked as lost before any new data */
+    if (fast_retransmit_pending_ and not sending_bytes_.empty()) {
+        retransmit(sending_bytes_.front(), transmit);
+    }
+    fast_retransmit_pending_ = false;
+    retransmit_lost(transmit);
+    if (lost_bytes_ > 0) {
+        return;
+    }
+
+    /* send as much as possible, within both the receiver's and the congestion window, and the pace */
     while (not fin_) {
+        if (pacing_rate().has_value() and pacing_tokens_ <= 0) {
+            return;
+        }
+
         auto send_msg {make_empty_message()};
-        auto max_payload_len = min((uint64_t)rwnd_, TCPConfig::MAX_PAYLOAD_SIZE) - send_msg.SYN;
+        const uint64_t window = min<uint64_t>(rwnd_, congestion_window_room());
+        auto max_payload_len = min(window, max_payload_size_) - send_msg.SYN;
+        if (send_msg.SYN and send_msg.fast_open_cookie == "") {
+            max_payload_len = 0; // asking for a cookie: the server would not take the data yet
+        }
 
+        /* the bytes stay retained in the stream until acknowledged */
         send_msg.payload = reader_.peek().substr(0, max_payload_len);
-        reader_.pop(send_msg.payload.size());
+        reader_.pop_and_retain(send_msg.payload.size());
 
         uint64_t seq_len = send_msg.sequence_length();
         rwnd_ = (rwnd_ > seq_len) ? rwnd_ - seq_len : 0;
-        send_msg.FIN = rwnd_ != 0 and reader_.is_finished();
+        send_msg.FIN = window > seq_len and reader_.is_finished();
         fin_ = send_msg.FIN;
         rwnd_ -= send_msg.FIN;
         seq_len += send_msg.FIN;
@@ -35,12 +116,23 @@ void TCPSender::push(const TransmitFunction& transmit) {
 
         /* first bytes sent, wait for new rwnd */
         if (last_byte_sent_ == 0) {
-            rwnd_ = 0;
+            rwnd_ = syn_window_ > seq_len ? syn_window_ - seq_len : 0;
         }
 
+        const auto acked_at_send = in_fast_recovery_ ? optional<uint64_t> {} : last_byte_acked_;
+        sending_bytes_.push_back({last_byte_sent_,
+                                  seq_len,
+                                  send_msg.SYN,
+                                  send_msg.FIN,
+                                  now_ms_,
+                                  acked_at_send,
+                                  loss_events_,
+                                  false,
+                                  false,
+                                  false});
         last_byte_sent_ += seq_len;
-        sending_bytes_.emplace(send_msg);
         transmit(send_msg);
+        spend_pacing_tokens(seq_len);
 
         /* reset message sent */
         if (send_msg.RST) {
@@ -50,7 +142,31 @@ void TCPSender::push(const TransmitFunction& transmit) {
 }
 
 TCPSenderMessage TCPSender::make_empty_message() const {
-    return {Wrap32::wrap(last_byte_sent_, isn_), last_byte_sent_ == 0, {}, {}, writer().has_error()};
+    const bool SYN = last_byte_sent_ == 0;
+    return {Wrap32::wrap(last_byte_sent_, isn_),
+            SYN,
+            {},
+            {},
+            writer().has_error(),
+            SYN,
+            SYN ? fast_open_cookie_ : nullopt};
+}
+
+void TCPSender::enable_fast_open(optional<string> cookie) {
+    fast_open_cookie_ = move(cookie).value_or("");
+}
+
+void TCPSender::on_syn_data_refused() {
+    /* split the SYN from its data, which is resent at once rather than after a timeout (RFC 7413 4.2.2) */
+    auto& syn = sending_bytes_.front();
+    OutstandingSegment data = syn;
+    data.seqno += 1;
+    data.length -= 1;
+    data.SYN = false;
+    syn.length = 1;
+    syn.FIN = false;
+    sending_bytes_.insert(sending_bytes_.begin() + 1, data);
+    mark_lost(sending_bytes_[1]);
 }
 
 void TCPSender::receive(const TCPReceiverMessage& msg) {
@@ -59,7 +175,22 @@ void TCPSender::receive(const TCPReceiverMessage& msg) {
         writer().set_error();
     }
 
+    /* the peer accepts segments of at most this size; it says so once, on its SYN, and the MSS then holds. A
+       peer that opened the connection sent that SYN before any ackno, so this comes first */
+    if (msg.max_segment_size.value_or(0) > 0 and not peer_mss_seen_) {
+        peer_mss_seen_ = true;
+        max_payload_size_ = min<uint64_t>(max_payload_size_limit_, msg.max_segment_size.value());
+        if (congestion_control_) {
+            congestion_control_->set_mss(max_payload_size_);
+        }
+    }
+
     if (not msg.ackno.has_value()) {
+        /* the peer's SYN reached a Fast Open server: its cookies are the adapter's business (RFC 7413 4.2.2) */
+        if (last_byte_sent_ == 0 and fast_open_cookie_.has_value()) {
+            fast_open_cookie_.reset();
+            syn_window_ = max<uint64_t>(msg.window_size, 1);
+        }
         return;
     }
 
@@ -69,42 +200,314 @@ void TCPSender::receive(const TCPReceiverMessage& msg) {
         return;
     }
 
+    /* only a Fast Open SYN carries data on a cookie; without one, a SYN+FIN waits for its timeout as before */
+    if (ackno == 1 and last_byte_acked_ == 0 and fast_open_cookie_.value_or("") != "" and not sending_bytes_.empty()
+        and sending_bytes_.front().SYN and sending_bytes_.front().length > 1u + sending_bytes_.front().FIN) {
+        on_syn_data_refused();
+    }
+
+    const uint64_t previously_acked = last_byte_acked_;
+    optional<uint64_t> rtt_sample {};
+    optional<uint64_t> acked_at_send {};
     while (!sending_bytes_.empty()) {
-        auto seq_len = sending_bytes_.front().sequence_length();
+        const auto& front = sending_bytes_.front();
+        auto seq_len = front.length;
         if (ackno < last_byte_acked_ + seq_len) { /* incomplete ack */
             break;
         }
 
+        /* Karn's rule: the newest segment acked gives the sample, unless it was retransmitted */
+        rtt_sample = front.retransmitted ? optional<uint64_t> {} : now_ms_ - front.sent_at_ms;
+        const bool rate_valid = not front.retransmitted and front.loss_events_at_send == loss_events_;
+        acked_at_send = rate_valid ? front.acked_at_send : optional<uint64_t> {};
+
         /* transmitted successfully, pop and update ackno */
-        sending_bytes_.pop();
+        sacked_bytes_ -= front.sacked ? seq_len : 0;
+        lost_bytes_ -= front.lost ? seq_len : 0;
+        input_.reader().release(seq_len - front.SYN - front.FIN);
+        sending_bytes_.pop_front();
         last_byte_acked_ += seq_len;
-
-        /* reset timer */
-        timer_ = 0;
         retransmission_cnt_ = 0;
+    }
+
+    const bool acked_new_data = last_byte_acked_ > previously_acked;
+    if (not msg.sack_blocks.empty()) {
+        update_scoreboard(msg.sack_blocks);
+    }
+
+    const bool was_in_fast_recovery = in_fast_recovery_;
+    if (acked_new_data) {
+        duplicate_acks_ = 0;
+        if (on_recovery_ack(last_byte_acked_ - previously_acked)) {
+            timer_ = 0;
+        }
+    } else if (congestion_control_ and ackno == last_byte_acked_ and not sending_bytes_.empty()) {
+        /* without a controller the sender keeps to plain RTO retransmission */
+        on_duplicate_ack();
+    }
+    if (congestion_control_ and not msg.sack_blocks.empty()) {
+        mark_sack_losses();
+        if (not sending_bytes_.empty() and sending_bytes_.front().lost) {
+            enter_fast_recovery();
+        }
+    }
+
+    /* fixed RTO is simply reset; an estimated RTO keeps any back-off until a valid sample arrives */
+    if (acked_new_data and not rto_bounds_.has_value()) {
         RTO_ms_ = initial_RTO_ms_;
+    } else if (rtt_sample.has_value()) {
+        sample_RTT(rtt_sample.value());
+    }
+
+    /* the window does not grow during fast recovery */
+    if (acked_new_data and congestion_control_ and not was_in_fast_recovery) {
+        AckSample sample {now_ms_, last_byte_acked_ - previously_acked, bytes_in_pipe(), rtt_sample};
+        if (acked_at_send.has_value()) {
+            /* bytes delivered while the newest acked segment was in flight, over its RTT */
+            sample.delivery_rate = static_cast<double>(last_byte_acked_ - acked_at_send.value())
+                                   / static_cast<double>(max<uint64_t>(rtt_sample.value(), 1));
+        }
+        congestion_control_->on_ack(sample);
     }
 
-    if (msg.window_size == 0) {
+    /* the receiver's window in bytes, scaled as RFC 7323 */
+    const auto window_scale = min(msg.window_scale.value_or(0), TCPReceiverMessage::MAX_WINDOW_SCALE);
+    const uint64_t window = uint64_t {msg.window_size} << window_scale;
+    if (window == 0) {
         rwnd_ = 1; // treat window_size 0 as 1
-    } else if (msg.window_size > sequence_numbers_in_flight()) {
-        rwnd_ = msg.window_size - sequence_numbers_in_flight();
+    } else if (window > sequence_numbers_in_flight()) {
+        rwnd_ = window - sequence_numbers_in_flight();
     }
 
-    zero_rwnd_ = msg.window_size == 0; // rwnd ?= 0
+    zero_rwnd_ = window == 0; // rwnd ?= 0
+
+    if (max_capacity_.has_value()) {
+        autotune(window);
+    }
 }
 
-void TCPSender::tick(uint64_t ms_since_last_tick, const TransmitFunction& transmit) {
-    if (sending_bytes_.empty()) { /* no bytes sending */
+void TCPSender::enable_autotuning(uint64_t max_capacity) {
+    max_capacity_ = max(max_capacity, input_.capacity());
+}
+
+void TCPSender::autotune(uint64_t window) {
+    /* room for a full window retained for retransmission and as much again queued behind it */
+    const uint64_t cwnd = congestion_control_ ? congestion_control_->congestion_window() : UINT64_MAX;
+    const uint64_t target = min(2 * min(window, cwnd), max_capacity_.value());
+    if (target > input_.capacity()) {
+        input_.grow_capacity(target);
+    }
+}
+
+void TCPSender::on_duplicate_ack() {
+    ++duplicate_acks_;
+
+    /* with SACK, the scoreboard already knows which segments left the network */
+    if (in_fast_recovery_) {
+        recovery_inflation_ += SACK_seen_ ? 0 : congestion_control_->mss();
+    } else if (duplicate_acks_ >= DUPLICATE_ACK_THRESHOLD) {
+        enter_fast_recovery();
+    }
+}
+
+void TCPSender::enter_fast_recovery() {
+    /* don't react twice to losses from the same window */
+    if (in_fast_recovery_ or last_byte_acked_ < recovery_point_) {
         return;
     }
+
+    in_fast_recovery_ = true;
+    partial_ack_seen_ = false;
+    ++loss_events_;
+    fast_retransmit_pending_ = true;
+    recovery_point_ = last_byte_sent_;
+    congestion_control_->on_loss(now_ms_, sequence_numbers_in_flight());
+    recovery_inflation_ = SACK_seen_ ? 0 : DUPLICATE_ACK_THRESHOLD * congestion_control_->mss();
+}
+
+void TCPSender::update_scoreboard(const vector<SACKBlock>& blocks) {
+    SACK_seen_ = true;
+    for (const auto& block : blocks) {
+        const uint64_t left = block.left.unwrap(isn_, last_byte_acked_);
+        const uint64_t right = block.right.unwrap(isn_, last_byte_acked_);
+        if (left >= right or right > last_byte_sent_) { /* invalid block */
+            continue;
+        }
+
+        /* mark the segments wholly inside the block */
+        auto it = partition_point(sending_bytes_.begin(), sending_bytes_.end(), [&](const auto& segment) {
+            return segment.seqno < left;
+        });
+        for (; it != sending_bytes_.end() and it->seqno + it->length <= right; ++it) {
+            if (not it->sacked) {
+                it->sacked = true;
+                sacked_bytes_ += it->length;
+                lost_bytes_ -= it->lost ? it->length : 0;
+                it->lost = false;
+            }
+        }
+    }
+}
+
+void TCPSender::mark_sack_losses() {
+    /* a hole is lost once DUPLICATE_ACK_THRESHOLD SACKed segments lie above it (RFC 6675 IsLost) */
+    uint64_t sacked_above = 0;
+    auto it = sending_bytes_.rbegin();
+    for (; it != sending_bytes_.rend() and sacked_above < DUPLICATE_ACK_THRESHOLD; ++it) {
+        sacked_above += it->sacked;
+    }
+    if (sacked_above < DUPLICATE_ACK_THRESHOLD) {
+        return;
+    }
+    const uint64_t lost_below = prev(it)->seqno;
+
+    /* each hole is marked once; if its retransmission is lost as well, the timer recovers it */
+    for (auto& segment : sending_bytes_) {
+        if (segment.seqno >= lost_below) {
+            break;
+        }
+        if (segment.seqno >= sack_lost_up_to_) {
+            mark_lost(segment);
+        }
+    }
+    sack_lost_up_to_ = max(sack_lost_up_to_, lost_below);
+}
+
+bool TCPSender::on_recovery_ack(const uint64_t bytes_acked) {
+    if (not in_fast_recovery_) {
+        return true;
+    }
+
+    /* full ACK: recovery is over */
+    if (last_byte_acked_ >= recovery_point_) {
+        in_fast_recovery_ = false;
+        recovery_inflation_ = 0;
+        return true;
+    }
+
+    /* partial ACK: the next segment was lost too, so resend it right away (unless the scoreboard already did) */
+    if (SACK_seen_) {
+        auto& front = sending_bytes_.front();
+        if (front.seqno >= sack_lost_up_to_) {
+            mark_lost(front);
+            sack_lost_up_to_ = front.seqno + front.length;
+        }
+    } else {
+        const uint64_t mss = congestion_control_->mss();
+        recovery_inflation_ = recovery_inflation_ > bytes_acked ? recovery_inflation_ - bytes_acked : 0;
+        if (bytes_acked >= mss) {
+            recovery_inflation_ += mss;
+        }
+        fast_retransmit_pending_ = true;
+    }
+
+    /* "impatient" variant (RFC 6582 4.2): only the first partial ACK restarts the timer, so a window with
+       many losses falls back to a timeout instead of repairing one hole per RTT */
+    const bool first_partial_ack = not partial_ack_seen_;
+    partial_ack_seen_ = true;
+    return first_partial_ack;
+}
+
+void TCPSender::sample_RTT(const uint64_t rtt_ms) {
+    constexpr double alpha = 1.0 / 8;
+    constexpr double beta = 1.0 / 4;
+    const auto rtt = static_cast<double>(rtt_ms);
+
+    if (not RTT_sampled_) {
+        SRTT_ms_ = rtt;
+        RTTVAR_ms_ = rtt / 2;
+        RTT_sampled_ = true;
+    } else {
+        RTTVAR_ms_ = (1 - beta) * RTTVAR_ms_ + beta * abs(SRTT_ms_ - rtt);
+        SRTT_ms_ = (1 - alpha) * SRTT_ms_ + alpha * rtt;
+    }
+
+    const auto rto = static_cast<uint64_t>(ceil(SRTT_ms_ + max<double>(CLOCK_GRANULARITY_MS, 4 * RTTVAR_ms_)));
+    RTO_ms_ = clamp(rto, rto_bounds_->min_ms, rto_bounds_->max_ms);
+}
+
+void TCPSender::enable_pacing(optional<double> rate_bytes_per_ms) {
+    pacing_ = true;
+    fixed_pacing_rate_ = rate_bytes_per_ms;
+    pacing_tokens_ = static_cast<double>(PACING_BURST_SEGMENTS * max_payload_size_);
+}
+
+optional<double> TCPSender::pacing_rate() const {
+    if (not pacing_ or fixed_pacing_rate_.has_value()) {
+        return fixed_pacing_rate_;
+    }
+    if (not congestion_control_) {
+        return {};
+    }
+
+    /* window-based controllers are paced a little faster than cwnd/SRTT, so the pace never limits them */
+    const auto rate = congestion_control_->pacing_rate();
+    if (rate.has_value() or not RTT_sampled_) {
+        return rate;
+    }
+    const double gain = congestion_control_->in_slow_start() ? PACING_GAIN_SLOW_START : PACING_GAIN;
+    return gain * static_cast<double>(congestion_control_->congestion_window()) / max(SRTT_ms_, 1.0);
+}
+
+void TCPSender::refill_pacing_tokens(const uint64_t ms) {
+    /* until there is a rate, the bucket stays full for when pacing starts */
+    const auto rate = pacing_rate();
+    const auto burst = static_cast<double>(PACING_BURST_SEGMENTS * max_payload_size_);
+    if (not rate.has_value()) {
+        pacing_tokens_ = burst;
+        return;
+    }
+
+    /* a bucket that ran dry was holding segments back, and gets the whole tick's worth */
+    const double earned = rate.value() * static_cast<double>(ms);
+    const double limit = pacing_tokens_ <= 0 ? max(earned, burst) : burst;
+    pacing_tokens_ = min(pacing_tokens_ + earned, limit);
+}
+
+void TCPSender::spend_pacing_tokens(const uint64_t bytes) {
+    if (pacing_rate().has_value()) {
+        pacing_tokens_ -= static_cast<double>(bytes);
+    }
+}
+
+void TCPSender::tick(uint64_t ms_since_last_tick, const TransmitFunction& transmit) {
+    now_ms_ += ms_since_last_tick;
+    if (not sending_bytes_.empty()) {
+        run_retransmission_timer(ms_since_last_tick, transmit);
+    }
+
+    /* release what the pace held back */
+    if (pacing_) {
+        refill_pacing_tokens(ms_since_last_tick);
+        push(transmit);
+    }
+}
+
+void TCPSender::run_retransmission_timer(uint64_t ms_since_last_tick, const TransmitFunction& transmit) {
     timer_ += ms_since_last_tick;
 
     if (timer_ >= RTO_ms_) {
-        transmit(sending_bytes_.front()); // retransmission
+        retransmit(sending_bytes_.front(), transmit);
         if (not zero_rwnd_) {
+            if (congestion_control_) {
+                congestion_control_->on_timeout(now_ms_, bytes_in_pipe());
+                /* SACKed segments keep their mark and are not resent (RFC 6675 5.1 leaves this open) */
+                for (auto& segment : sending_bytes_ | views::drop(1)) {
+                    mark_lost(segment);
+                }
+                sack_lost_up_to_ = last_byte_sent_;
+            }
+            ++loss_events_;
+            in_fast_recovery_ = false;
+            fast_retransmit_pending_ = false;
+            duplicate_acks_ = 0;
+            recovery_point_ = last_byte_sent_;
+            recovery_inflation_ = 0;
             retransmission_cnt_++;
             RTO_ms_ *= 2;
+            if (rto_bounds_.has_value()) {
+                RTO_ms_ = min(RTO_ms_, rto_bounds_->max_ms);
+            }
         }
         timer_ = 0;
     }
@@ -1,21 +1,53 @@
 #pragma once
 
 #include "byte_stream.hh"
+#include "congestion_control.hh"
+#include "tcp_config.hh"
 #include "tcp_receiver_message.hh"
 #include "tcp_sender_message.hh"
 
 #include <cstdint>
+#include <deque>
 #include <functional>
 #include <list>
 #include <memory>
 #include <optional>
 #include <queue>
+#include <string>
+#include <vector>
 
 class TCPSender {
   public:
-    /* Construct TCP sender with given default Retransmission Timeout and possible ISN */
-    TCPSender(ByteStream&& input, Wrap32 isn, uint64_t initial_RTO_ms)
-      : input_(std::move(input)), isn_(isn), initial_RTO_ms_(initial_RTO_ms), RTO_ms_(initial_RTO_ms) {}
+    /* Lower and upper bounds on a Retransmission Timeout estimated from RTT samples */
+    struct RTOBounds {
+        uint64_t min_ms;
+        uint64_t max_ms;
+    };
+
+    /* Construct TCP sender with given default Retransmission Timeout and possible ISN.
+       Without `rto_bounds`, the RTO stays at `initial_RTO_ms` (doubling on each timeout). With them, it is
+       estimated from RTT samples as in RFC 6298 and clamped to the bounds.
+       Without `congestion_control`, only the receiver's window limits how much is in flight; a controller
+       that needs pacing (such as BBR) has it enabled at once.
+       Segments carry at most `max_payload_size` bytes, or less if the peer's receiver accepts less. */
+    TCPSender(ByteStream&& input,
+              Wrap32 isn,
+              uint64_t initial_RTO_ms,
+              std::optional<RTOBounds> rto_bounds = {},
+              std::unique_ptr<CongestionController> congestion_control = nullptr,
+              uint64_t max_payload_size = TCPConfig::MAX_PAYLOAD_SIZE)
+      : input_(std::move(input))
+      , isn_(isn)
+      , initial_RTO_ms_(initial_RTO_ms)
+      , RTO_ms_(initial_RTO_ms)
+      , rto_bounds_(rto_bounds)
+      , congestion_control_(std::move(congestion_control))
+      , max_payload_size_limit_(max_payload_size)
+      , max_payload_size_(max_payload_size) {
+        if (congestion_control_ and congestion_control_->needs_pacing()) {
+            enable_pacing();
+        }
+    }
 
     /* Generate an empty TCPSenderMessage */
     TCPSenderMessage make_empty_message() const;
@@ -32,9 +64,31 @@ class TCPSender {
     /* Time has passed by the given # of milliseconds since the last time the tick() method was called */
     void tick(uint64_t ms_since_last_tick, const TransmitFunction& transmit);
 
+    /* Spread segments out at `rate_bytes_per_ms` instead of sending a window in one burst. Without a rate,
+       pace at the congestion controller's rate, or else at the congestion window per smoothed RTT.
+       What the pace holds back is sent by tick(). */
+    void enable_pacing(std::optional<double> rate_bytes_per_ms = {});
+
+    /* TCP Fast Open (RFC 7413), before the first push: with a cookie the server issued earlier, the SYN carries
+       it and as much of the stream as fits; without one, the SYN asks for a cookie and carries no data.
+       Enabled on a server before the peer's SYN arrives, the sender may send within that SYN's window before
+       the handshake completes. */
+    void enable_fast_open(std::optional<std::string> cookie = {});
+
+    /* Send-buffer autotuning: the bytes in flight stay retained in the outbound stream and use up its capacity,
+       so let it grow, up to `max_capacity`, to twice what the peer's window and the congestion window allow in
+       flight (Linux sizes its send buffer from the congestion window the same way). */
+    void enable_autotuning(uint64_t max_capacity);
+
     // Accessors
     uint64_t sequence_numbers_in_flight() const;  // How many sequence numbers are outstanding?
     uint64_t consecutive_retransmissions() const; // How many consecutive *re*transmissions have happened?
+    double SRTT_ms() const { return SRTT_ms_; }     // Smoothed RTT (0 until the first sample)
+    double RTTVAR_ms() const { return RTTVAR_ms_; } // RTT variation (0 until the first sample)
+    uint64_t RTO_ms() const { return RTO_ms_; }     // Current RTO, including any back-off
+    uint64_t max_payload_size() const { return max_payload_size_; } // Largest payload per segment
+    std::optional<double> pacing_rate() const; // bytes/ms, if pacing and a rate is known yet
+    const CongestionController* congestion_controller() const { return congestion_control_.get(); }
     Writer& writer() { return input_.writer(); }
     const Writer& writer() const { return input_.writer(); }
 
@@ -48,11 +102,105 @@ class TCPSender {
     uint64_t initial_RTO_ms_;
     uint64_t RTO_ms_ {};
     uint64_t timer_ {};
-    uint16_t rwnd_ {INT16_MAX};
+    uint64_t rwnd_ {INT16_MAX};
     uint64_t last_byte_acked_ {};
     uint64_t last_byte_sent_ {};
     uint64_t retransmission_cnt_ {};
     bool zero_rwnd_ {};
     bool fin_ {};
-    std::queue<TCPSenderMessage> sending_bytes_ {};
+
+    /* segments sent but not yet acknowledged, with the time they were (first) sent and how many bytes
+       had been acknowledged by then (for delivery-rate samples). Their payloads stay retained in the input
+       stream until acknowledged, and a retransmission is rebuilt from there. */
+    struct OutstandingSegment {
+        uint64_t seqno;  // absolute
+        uint64_t length; // sequence numbers used, including SYN and FIN
+        bool SYN;
+        bool FIN;
+        uint64_t sent_at_ms;
+        std::optional<uint64_t> acked_at_send; // empty if sent during fast recovery
+        uint64_t loss_events_at_send;
+        bool retransmitted;
+        bool sacked; // the receiver holds it already
+        bool lost;   // presumed lost and not yet resent
+    };
+    std::deque<OutstandingSegment> sending_bytes_ {};
+    TCPSenderMessage make_message(const OutstandingSegment& segment) const;
+
+    /* RTT estimator (RFC 6298), used only when bounds are given */
+    static constexpr uint64_t CLOCK_GRANULARITY_MS = 1;
+    void sample_RTT(uint64_t rtt_ms);
+    std::optional<RTOBounds> rto_bounds_;
+    uint64_t now_ms_ {};
+    bool RTT_sampled_ {};
+    double SRTT_ms_ {};
+    double RTTVAR_ms_ {};
+
+    /* how many more sequence numbers the congestion controller allows in flight */
+    uint64_t congestion_window_room() const;
+    std::unique_ptr<CongestionController> congestion_control_;
+
+    /* the sender's own limit, and the one in effect once the peer has said (on its SYN) how much it accepts */
+    uint64_t max_payload_size_limit_;
+    uint64_t max_payload_size_;
+    bool peer_mss_seen_ {};
+
+    /* pacing: a token bucket of bytes, refilled by tick(). A segment may overdraw it. An idle sender saves up
+       at most PACING_BURST_SEGMENTS segments; one held back by the pace gets a whole tick's worth at once,
+       so coarse ticks still reach the rate. */
+    static constexpr uint64_t PACING_BURST_SEGMENTS = 2;
+    static constexpr double PACING_GAIN_SLOW_START = 2.0; // keeps up with a window that doubles each RTT
+    static constexpr double PACING_GAIN = 1.25;
+    void refill_pacing_tokens(uint64_t ms);
+    void spend_pacing_tokens(uint64_t bytes);
+    bool pacing_ {};
+    std::optional<double> fixed_pacing_rate_ {};
+    double pacing_tokens_ {};
+
+    void run_retransmission_timer(uint64_t ms_since_last_tick, const TransmitFunction& transmit);
+
+    /* Fast Open: the cookie our SYN carries (empty to request one), and as a server, the window of the peer's
+       SYN, open before our SYN is acknowledged */
+    std::optional<std::string> fast_open_cookie_ {};
+    uint64_t syn_window_ {};
+
+    /* send-buffer autotuning, once enabled */
+    void autotune(uint64_t window);
+    std::optional<uint64_t> max_capacity_ {};
+
+    /* a SYN-ACK that acknowledges only the SYN: the server did not accept the data sent with it */
+    void on_syn_data_refused();
+
+    /* with congestion control, a timeout marks everything outstanding as lost (RFC 5681 3.1); lost segments
+       are resent in order as the window allows. Until then they, like SACKed segments, leave the pipe. */
+    uint64_t bytes_in_pipe() const;
+    void mark_lost(OutstandingSegment& segment);
+    void retransmit(OutstandingSegment& segment, const TransmitFunction& transmit);
+    void retransmit_lost(const TransmitFunction& transmit);
+    uint64_t sacked_bytes_ {};
+    uint64_t lost_bytes_ {};
+
+    /* fast retransmit and NewReno fast recovery (RFC 5681 3.2, RFC 6582): each duplicate ACK beyond the
+       threshold means one more segment has left the network, so `recovery_inflation_` leaves the pipe too */
+    static constexpr uint64_t DUPLICATE_ACK_THRESHOLD = 3;
+    void on_duplicate_ack();
+    void enter_fast_recovery();
+    bool on_recovery_ack(uint64_t bytes_acked); // returns whether to restart the retransmission timer
+    uint64_t duplicate_acks_ {};
+    bool in_fast_recovery_ {};
+    bool partial_ack_seen_ {};
+    bool fast_retransmit_pending_ {};
+    uint64_t recovery_point_ {};
+    uint64_t recovery_inflation_ {};
+
+    /* a cumulative ACK that fills a hole acknowledges a window's worth at once, so segments in flight across
+       a loss give no delivery-rate sample */
+    uint64_t loss_events_ {};
+
+    /* SACK scoreboard (RFC 6675): once the peer reports SACK blocks, a hole is presumed lost when enough
+       SACKed segments lie above it, so every hole in a window can be repaired within one round trip */
+    void update_scoreboard(const std::vector<SACKBlock>& blocks);
+    void mark_sack_losses();
+    bool SACK_seen_ {};
+    uint64_t sack_lost_up_to_ {}; // holes below this were already marked lost once
 };
@@ -1,11 +1,47 @@
+#include <unistd.h>
+
+#include <array>
 #include <exception>
+#include <fstream>
 #include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
 
 #include "byte_stream.hh"
 #include "byte_stream_test_harness.hh"
 
 using namespace std;
 
+namespace {
+// The mappings of ByteStream rings in this process
+size_t ring_mappings() {
+    ifstream maps {"/proc/self/maps"};
+    size_t count = 0;
+    for (string line; getline(maps, line);) {
+        count += line.find("memfd:ring_buffer") != string::npos;
+    }
+    return count;
+}
+
+// The memfds (by inode) behind ByteStream rings in this process
+set<string> ring_memfds() {
+    ifstream maps {"/proc/self/maps"};
+    set<string> inodes;
+    for (string line; getline(maps, line);) {
+        if (line.find("memfd:ring_buffer") != string::npos) {
+            istringstream fields {line};
+            string field;
+            for (int i = 0; i < 5; ++i) {
+                fields >> field;
+            }
+            inodes.insert(field);
+        }
+    }
+    return inodes;
+}
+} // namespace
+
 int main() {
     try {
         {
@@ -96,6 +132,257 @@ int main() {
             test.execute(BytesBuffered {1});
         }
 
+        {
+            ByteStreamTestHarness test {"retained bytes hold their space until released", 4};
+
+            test.execute(Push {"abcd"});
+            test.execute(PopAndRetain {3});
+            test.execute(BytesPopped {3});
+            test.execute(BytesBuffered {1});
+            test.execute(BytesRetained {3});
+            test.execute(AvailableCapacity {0});
+            test.execute(Retained {1, "bc"});
+
+            test.execute(Release {2});
+            test.execute(BytesRetained {1});
+            test.execute(AvailableCapacity {2});
+            test.execute(Retained {0, ""});
+            test.execute(Retained {2, "c"});
+
+            /* bytes popped behind retained ones are retained too */
+            test.execute(Push {"efgh"});
+            test.execute(BytesPushed {6});
+            test.execute(Pop {2});
+            test.execute(BytesRetained {3});
+            test.execute(Retained {2, "cde"});
+            test.execute(Release {10});
+            test.execute(BytesRetained {0});
+            test.execute(AvailableCapacity {3});
+            test.execute(Peek {"f"});
+
+            test.execute(Pop {1});
+            test.execute(BytesRetained {0});
+            test.execute(AvailableCapacity {4});
+        }
+
+        {
+            ByteStreamTestHarness test {"growing keeps the buffered bytes", 2};
+
+            test.execute(Push {"cat"});
+            test.execute(GrowCapacity {5});
+            test.execute(Capacity {5});
+            test.execute(AvailableCapacity {3});
+            test.execute(Push {"tail"});
+            test.execute(Peek {"catai"});
+            test.execute(GrowCapacity {3});
+            test.execute(Capacity {5});
+        }
+
+        {
+            ByteStreamTestHarness test {"reserve offers at most the available capacity", 4};
+
+            test.execute(ReserveSize {10, 4});
+            test.execute(CommitReserved {"ab", 2});
+            test.execute(BytesPushed {2});
+            test.execute(Peek {"ab"});
+            test.execute(ReserveSize {10, 2});
+            test.execute(ReserveSize {1, 1});
+
+            /* a commit never appends more than fits */
+            test.execute(CommitReserved {"cdef", 4});
+            test.execute(BytesPushed {4});
+            test.execute(AvailableCapacity {0});
+            test.execute(ReserveSize {1, 0});
+            test.execute(Peek {"abcd"});
+
+            test.execute(Pop {3});
+            test.execute(ReserveSize {10, 3});
+            test.execute(CommitReserved {"xyz", 1});
+            test.execute(BytesPushed {5});
+            test.execute(Peek {"dx"});
+        }
+
+        {
+            ByteStreamTestHarness test {"a closed stream reserves nothing", 4};
+
+            test.execute(CommitReserved {"ab", 2});
+            test.execute(Close {});
+            test.execute(ReserveSize {4, 0});
+            test.execute(CommitReserved {"cd", 2});
+            test.execute(BytesPushed {2});
+            test.execute(Peek {"ab"});
+        }
+
+        {
+            ByteStreamTestHarness test {"read_into fills the reserved space", 5};
+
+            array<int, 2> fds {};
+            if (pipe(fds.data()) != 0) {
+                throw unix_error {"pipe"};
+            }
+            FileDescriptor read_end {fds[0]};
+            FileDescriptor write_end {fds[1]};
+
+            write_end.write("hello world");
+            test.execute(ReadInto {read_end});
+            test.execute(BytesPushed {5});
+            test.execute(Peek {"hello"});
+
+            /* a full stream reads nothing */
+            test.execute(ReadInto {read_end});
+            test.execute(BytesPushed {5});
+
+            test.execute(Pop {5});
+            test.execute(ReadInto {read_end});
+            test.execute(Peek {" worl"});
+            test.execute(Pop {2});
+            write_end.close();
+            test.execute(ReadInto {read_end});
+            test.execute(Peek {"orld"});
+            test.execute(ReadInto {read_end});
+            test.execute(BytesPushed {11});
+            if (not read_end.eof()) {
+                throw runtime_error("read_into did not see the end of the pipe");
+            }
+        }
+
+        {
+            ByteStreamTestHarness test {"peek_all covers the buffered bytes", 4};
+
+            test.execute(PeekAll {4, ""});
+            test.execute(Push {"abc"});
+            test.execute(PeekAll {10, "abc"});
+            test.execute(PeekAll {2, "ab"});
+            test.execute(PeekAll {0, ""});
+
+            /* the buffered bytes wrap around the end of the ring */
+            test.execute(Pop {2});
+            test.execute(Push {"def"});
+            test.execute(PeekAll {10, "cdef"});
+            test.execute(PeekAll {3, "cde"});
+            test.execute(Pop {3});
+            test.execute(PeekAll {10, "f"});
+            test.execute(Pop {1});
+            test.execute(PeekAll {10, ""});
+        }
+
+        /* the ring is a whole number of pages, so these cases are laid out in pages */
+        const auto page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+
+        {
+            const string data = [&] {
+                string s;
+                for (unsigned i = 0; s.size() < 8 * page; ++i) {
+                    s += to_string(i) + ",";
+                }
+                return s.substr(0, 8 * page);
+            }();
+            ByteStreamTestHarness test {"growing while the buffered bytes wrap", 3 * page};
+
+            test.execute(Push {data.substr(0, page * 5 / 2)});
+            test.execute(Pop {page * 9 / 4});
+            test.execute(Push {data.substr(page * 5 / 2, page * 5 / 2)});
+            test.execute(BytesBuffered {page * 11 / 4});
+            test.execute(PeekAll {3 * page, data.substr(page * 9 / 4, page * 11 / 4)});
+            test.execute(GrowCapacity {10 * page});
+            test.execute(Capacity {10 * page});
+            test.execute(AvailableCapacity {page * 29 / 4});
+            test.execute(Peek {data.substr(page * 9 / 4, page * 11 / 4)});
+
+            test.execute(Push {data.substr(5 * page, 3 * page)});
+            test.execute(Peek {data.substr(page * 9 / 4)});
+            test.execute(Pop {5 * page});
+            test.execute(Push {data.substr(0, 4 * page)});
+            test.execute(Peek {data.substr(page * 29 / 4) + data.substr(0, 4 * page)});
+            test.execute(PeekAll {10 * page, data.substr(page * 29 / 4) + data.substr(0, 4 * page)});
+        }
+
+        {
+            ByteStreamTestHarness test {"growing while the bytes wrap within a page", page};
+
+            test.execute(Push {string(page * 3 / 4, 'a')});
+            test.execute(Pop {page * 5 / 8});
+            test.execute(Push {string(page * 3 / 4, 'b')});
+            test.execute(GrowCapacity {2 * page});
+            test.execute(Capacity {2 * page});
+            test.execute(AvailableCapacity {page * 9 / 8});
+            test.execute(Peek {string(page / 8, 'a') + string(page * 3 / 4, 'b')});
+            test.execute(Push {string(page, 'c')});
+            test.execute(Peek {string(page / 8, 'a') + string(page * 3 / 4, 'b') + string(page, 'c')});
+        }
+
+        {
+            ByteStreamTestHarness test {"growing while a few bytes wrap", page};
+
+            test.execute(Push {string(page * 3 / 4, 'a')});
+            test.execute(Pop {page / 2});
+            test.execute(Push {string(page / 2, 'b')});
+            test.execute(GrowCapacity {2 * page});
+            test.execute(AvailableCapacity {page * 5 / 4});
+            test.execute(Peek {string(page / 4, 'a') + string(page / 2, 'b')});
+            test.execute(Push {string(page, 'c')});
+            test.execute(Peek {string(page / 4, 'a') + string(page / 2, 'b') + string(page, 'c')});
+        }
+
+        {
+            /* growing extends the ring's memfd rather than copying the bytes to a new one */
+            const auto before = ring_memfds();
+            ByteStreamTestHarness test {"growing keeps the bytes in their memfd", page};
+            test.execute(Push {string(page / 2, 'a')});
+            const auto in_use = ring_memfds();
+            test.execute(GrowCapacity {8 * page});
+            test.execute(Peek {string(page / 2, 'a')});
+            if (ring_memfds() != in_use or in_use.size() != before.size() + 1) {
+                throw runtime_error("a grown ring moved to another memfd");
+            }
+        }
+
+        {
+            ByteStreamTestHarness test {"retained bytes move with the ring", page};
+
+            test.execute(Push {string(page * 3 / 4, 'a')});
+            test.execute(PopAndRetain {page / 2});
+            test.execute(Release {page / 4});
+            test.execute(Push {string(page / 2, 'b')});
+            test.execute(GrowCapacity {4 * page});
+            test.execute(BytesRetained {page / 4});
+            test.execute(Retained {page / 4, string(page / 4, 'a')});
+            test.execute(Peek {string(page / 4, 'a') + string(page / 2, 'b')});
+            test.execute(AvailableCapacity {page * 3});
+        }
+
+        {
+            /* however often it grows, a ring is one memfd mapped twice */
+            const size_t before = ring_mappings();
+            ByteStreamTestHarness test {"growing keeps the ring in one mapping", page};
+            for (uint64_t capacity = 2 * page; capacity <= 64 * page; capacity *= 2) {
+                test.execute(Push {string(page, 'x')});
+                test.execute(Pop {page / 2});
+                test.execute(GrowCapacity {capacity});
+            }
+            if (ring_mappings() != before + 2) {
+                throw runtime_error("a grown ring took " + to_string(ring_mappings() - before) + " mappings");
+            }
+        }
+
+        {
+            /* the ring is only mapped once the stream has bytes to hold */
+            const size_t before = ring_mappings();
+            ByteStreamTestHarness test {"an idle stream maps nothing", 64 * page};
+            test.execute(ReserveSize {0, 0});
+            test.execute(Peek {""});
+            test.execute(GrowCapacity {128 * page});
+            if (ring_mappings() != before) {
+                throw runtime_error("an idle stream took " + to_string(ring_mappings() - before) + " mappings");
+            }
+            test.execute(Push {"hello"});
+            test.execute(Capacity {128 * page});
+            test.execute(AvailableCapacity {128 * page - 5});
+            test.execute(Peek {"hello"});
+            if (ring_mappings() != before + 2) {
+                throw runtime_error("a stream in use took " + to_string(ring_mappings() - before) + " mappings");
+            }
+        }
     } catch (const exception& e) {
         cerr << "Exception: " << e.what() << endl;
         return EXIT_FAILURE;
@@ -37,6 +37,7 @@ void speed_test(const size_t input_len,   // NOLINT(bugprone-easily-swappable-pa
     ByteStream bs {capacity};
     string output_data;
     output_data.reserve(data.size());
+    size_t reads = 0;
 
     const auto start_time = steady_clock::now();
     while (not bs.reader().is_finished()) {
@@ -58,6 +59,7 @@ void speed_test(const size_t input_len,   // NOLINT(bugprone-easily-swappable-pa
             }
             output_data += peeked;
             bs.reader().pop(peeked.size());
+            ++reads;
         }
     }
 
@@ -76,7 +78,8 @@ void speed_test(const size_t input_len,   // NOLINT(bugprone-easily-swappable-pa
     debug_output.open("/dev/tty");
 
     cout << "ByteStream with capacity=" << capacity << ", write_size=" << write_size << ", read_size=" << read_size
-         << " reached " << fixed << setprecision(2) << gigabits_per_second << " Gbit/s.\n";
+         << " reached " << fixed << setprecision(2) << gigabits_per_second << " Gbit/s in " << reads
+         << " reads.\n";
 
     debug_output << "             ByteStream throughput: " << fixed << setprecision(2) << gigabits_per_second
                  << " Gbit/s\n";
@@ -88,6 +91,10 @@ void speed_test(const size_t input_len,   // NOLINT(bugprone-easily-swappable-pa
 
 void program_body() {
     speed_test(1e7, 32768, 789, 1500, 128);
+
+    // Drain the whole window per read, as the socket paths do on each event loop wakeup
+    speed_test(1e7, 32768, 789, 1500, 32768);
+    speed_test(1e8, 1048576, 789, 16384, 1048576);
 }
 
 int main() {
@@ -1,11 +1,13 @@
 #pragma once
 
+#include <algorithm>
 #include <concepts>
 #include <optional>
 #include <utility>
 
 #include "byte_stream.hh"
 #include "common.hh"
+#include "file_descriptor.hh"
 
 static_assert(sizeof(Reader) == sizeof(ByteStream),
               "Please add member variables to the ByteStream base, not the ByteStream Reader.");
@@ -31,6 +33,40 @@ struct Push : public Action<ByteStream> {
     void execute(ByteStream& bs) const override { bs.writer().push(data_); }
 };
 
+struct CommitReserved : public Action<ByteStream> {
+    std::string data_;
+    uint64_t commit_len_;
+
+    CommitReserved(std::string data, uint64_t commit_len) : data_(move(data)), commit_len_(commit_len) {}
+    std::string description() const override {
+        return "reserve( " + std::to_string(data_.size()) + " ), fill it from \"" + Printer::prettify(data_)
+               + "\", and commit( " + std::to_string(commit_len_) + " )";
+    }
+    void execute(ByteStream& bs) const override {
+        const auto space = bs.writer().reserve(data_.size());
+        std::copy_n(data_.begin(), space.size(), space.begin());
+        bs.writer().commit(commit_len_);
+    }
+};
+
+struct ReadInto : public Action<ByteStream> {
+    FileDescriptor& fd_;
+
+    explicit ReadInto(FileDescriptor& fd) : fd_(fd) {}
+    std::string description() const override { return "read from a file descriptor into the reserved space"; }
+    void execute(ByteStream& bs) const override {
+        bs.writer().commit(fd_.read_into(bs.writer().reserve(bs.writer().available_capacity())));
+    }
+};
+
+struct GrowCapacity : public Action<ByteStream> {
+    uint64_t capacity_;
+
+    explicit GrowCapacity(uint64_t capacity) : capacity_(capacity) {}
+    std::string description() const override { return "grow_capacity( " + std::to_string(capacity_) + " )"; }
+    void execute(ByteStream& bs) const override { bs.grow_capacity(capacity_); }
+};
+
 struct Close : public Action<ByteStream> {
     std::string description() const override { return "close"; }
     void execute(ByteStream& bs) const override { bs.writer().close(); }
@@ -49,6 +85,22 @@ struct Pop : public Action<ByteStream> {
     void execute(ByteStream& bs) const override { bs.reader().pop(len_); }
 };
 
+struct PopAndRetain : public Action<ByteStream> {
+    size_t len_;
+
+    explicit PopAndRetain(size_t len) : len_(len) {}
+    std::string description() const override { return "pop_and_retain( " + std::to_string(len_) + " )"; }
+    void execute(ByteStream& bs) const override { bs.reader().pop_and_retain(len_); }
+};
+
+struct Release : public Action<ByteStream> {
+    size_t len_;
+
+    explicit Release(size_t len) : len_(len) {}
+    std::string description() const override { return "release( " + std::to_string(len_) + " )"; }
+    void execute(ByteStream& bs) const override { bs.reader().release(len_); }
+};
+
 /* expectations */
 
 struct Peek : public Expectation<ByteStream> {
@@ -97,6 +149,31 @@ struct PeekOnce : public Peek {
     }
 };
 
+struct PeekAll : public Expectation<ByteStream> {
+    uint64_t len_;
+    std::string output_;
+
+    PeekAll(uint64_t len, std::string output) : len_(len), output_(move(output)) {}
+
+    std::string description() const override {
+        return "peek_all( " + std::to_string(len_) + " ) gives views of \"" + Printer::prettify(output_) + "\"";
+    }
+
+    void execute(ByteStream& bs) const override {
+        std::string got;
+        for (const auto view : bs.reader().peek_all(len_)) {
+            if (view.empty()) {
+                throw ExpectationViolation {"Reader::peek_all() returned an empty string_view"};
+            }
+            got += view;
+        }
+        if (got != output_) {
+            throw ExpectationViolation {"Expected views of \"" + Printer::prettify(output_) + "\", but found \""
+                                        + Printer::prettify(got) + "\""};
+        }
+    }
+};
+
 struct IsClosed : public ConstExpectBool<ByteStream> {
     using ConstExpectBool::ConstExpectBool;
     std::string name() const override { return "is_closed"; }
@@ -121,6 +198,47 @@ struct BytesBuffered : public ConstExpectNumber<ByteStream, uint64_t> {
     size_t value(const ByteStream& bs) const override { return bs.reader().bytes_buffered(); }
 };
 
+struct ReserveSize : public ExpectNumber<ByteStream, uint64_t> {
+    uint64_t len_;
+
+    ReserveSize(uint64_t len, uint64_t size) : ExpectNumber(size), len_(len) {}
+    std::string name() const override { return "reserve( " + std::to_string(len_) + " ).size()"; }
+    size_t value(ByteStream& bs) const override { return bs.writer().reserve(len_).size(); }
+};
+
+struct Capacity : public ConstExpectNumber<ByteStream, uint64_t> {
+    using ConstExpectNumber::ConstExpectNumber;
+    std::string name() const override { return "capacity"; }
+    size_t value(const ByteStream& bs) const override { return bs.capacity(); }
+};
+
+struct BytesRetained : public ConstExpectNumber<ByteStream, uint64_t> {
+    using ConstExpectNumber::ConstExpectNumber;
+    std::string name() const override { return "bytes_retained"; }
+    size_t value(const ByteStream& bs) const override { return bs.reader().bytes_retained(); }
+};
+
+struct Retained : public Expectation<ByteStream> {
+    uint64_t first_index_;
+    std::string output_;
+
+    Retained(uint64_t first_index, std::string output) : first_index_(first_index), output_(move(output)) {}
+
+    std::string description() const override {
+        return "retained( " + std::to_string(first_index_) + ", " + std::to_string(output_.size()) + " ) gives \""
+               + Printer::prettify(output_) + "\"";
+    }
+
+    void execute(ByteStream& bs) const override {
+        const auto got = bs.reader().retained(first_index_, output_.size());
+        if (got != output_) {
+            throw ExpectationViolation {"Expected \"" + Printer::prettify(output_) + "\" retained at index "
+                                        + std::to_string(first_index_) + ", but found \""
+                                        + Printer::prettify(got) + "\""};
+        }
+    }
+};
+
 struct BufferEmpty : public ExpectBool<ByteStream> {
     using ExpectBool::ExpectBool;
     std::string name() const override { return "[buffer is empty]"; }
@@ -0,0 +1,168 @@
+#include "checksum.hh"
+#include "random.hh"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+namespace {
+// The byte-at-a-time algorithm, used as the reference (with a sum wide enough for any buffer here)
+uint16_t reference_checksum(string_view data, uint64_t sum) {
+    bool parity = false;
+    for (const uint8_t i : data) {
+        uint16_t val = i;
+        if (not parity) {
+            val <<= 8;
+        }
+        sum += val;
+        parity = !parity;
+    }
+    while (sum > 0xffff) {
+        sum = (sum >> 16) + static_cast<uint16_t>(sum);
+    }
+    return static_cast<uint16_t>(~sum);
+}
+
+string random_string(default_random_engine& rd, size_t len) {
+    uniform_int_distribution<char> ud;
+    string ret;
+    for (size_t i = 0; i < len; ++i) {
+        ret += ud(rd);
+    }
+    return ret;
+}
+
+void expect_reference(string_view data, uint32_t initial, const string& what) {
+    InternetChecksum check {initial};
+    check.add(data);
+    if (check.value() != reference_checksum(data, initial)) {
+        throw runtime_error("InternetChecksum disagrees with the reference for " + what + " ("
+                            + to_string(data.size()) + " bytes)");
+    }
+}
+
+// Split random buffers at random (often odd) points, so that words straddle the pieces
+void split_test(default_random_engine& rd) {
+    for (size_t rep = 0; rep < 2000; ++rep) {
+        const string data = random_string(rd, rd() % 4096);
+        const uint32_t initial = rd() % 0x40000;
+
+        InternetChecksum check {initial};
+        size_t pos = 0;
+        while (pos < data.size()) {
+            const size_t len = min(data.size() - pos, static_cast<size_t>(rd() % 300));
+            check.add(string_view {data}.substr(pos, len));
+            pos += len;
+        }
+
+        if (check.value() != reference_checksum(data, initial)) {
+            throw runtime_error("InternetChecksum disagrees with the reference for a " + to_string(data.size())
+                                + "-byte buffer added in pieces");
+        }
+    }
+}
+
+// The vector kernels read 32- and 16-byte blocks from any address and leave what is left to narrower ones: try
+// every start offset and every length around the block sizes and the vector threshold
+void alignment_test(default_random_engine& rd) {
+    const string data = random_string(rd, 320);
+    for (size_t offset = 0; offset < 64; ++offset) {
+        for (size_t len = 0; len <= 256; ++len) {
+            expect_reference(string_view {data}.substr(offset, len), 0, "offset " + to_string(offset));
+        }
+    }
+}
+
+// Sums at the edges of ones'-complement arithmetic: zeros sum to +0 and 0xff bytes to -0, and a long run of
+// 0xff bytes takes every lane of a vector kernel to its limit before it is drained
+void edge_test() {
+    for (const size_t len : {size_t {0}, size_t {1}, size_t {2}, size_t {63}, size_t {64}, size_t {65},
+                             size_t {1500}, size_t {65536}, size_t {(1 << 20) + 3}}) {
+        for (const char byte : {'\x00', '\xff'}) {
+            const string data(len, byte);
+            for (const uint32_t initial : {0U, 0xffffU, 0x3ffffU}) {
+                expect_reference(data, initial, byte == '\x00' ? "zeros" : "0xff bytes");
+            }
+        }
+    }
+}
+uint16_t word_at(const string& data, size_t pos) {
+    return static_cast<uint16_t>(static_cast<uint8_t>(data[pos]) << 8 | static_cast<uint8_t>(data[pos + 1]));
+}
+
+void set_word(string& data, size_t pos, uint16_t word) {
+    data[pos] = static_cast<char>(word >> 8);
+    data[pos + 1] = static_cast<char>(word);
+}
+
+// Patch one 16-bit word at a time and compare the incremental update (RFC 1624) with a full recomputation
+void incremental_update_test(default_random_engine& rd) {
+    for (size_t rep = 0; rep < 2000; ++rep) {
+        string data = random_string(rd, 2 * (1 + rd() % 30));
+        uint16_t cksum = reference_checksum(data, 0);
+
+        for (size_t i = 0; i < 8; ++i) {
+            const size_t pos = 2 * (rd() % (data.size() / 2));
+            const uint16_t old_word = word_at(data, pos);
+            const auto new_word = static_cast<uint16_t>(rd());
+            set_word(data, pos, new_word);
+
+            cksum = InternetChecksum::update(cksum, old_word, new_word);
+            if (cksum != reference_checksum(data, 0)) {
+                throw runtime_error("InternetChecksum::update disagrees with a full recomputation");
+            }
+        }
+    }
+}
+
+// Words and checksums at the edges of ones'-complement arithmetic: 0x0000 and 0xffff (+0 and -0) as the old
+// or new word, and data whose sum is -0 (checksum 0x0000). Eqn. 3 never turns a checksum into 0xffff, which
+// only data that is all zeros has; an IPv4 header or TCP segment never is, so such data is left out.
+void incremental_update_edge_test() {
+    const array<uint16_t, 8> edges {0x0000, 0x0001, 0x7fff, 0x8000, 0xfffe, 0xffff, 0x1234, 0xedcb};
+    for (const uint16_t other : edges) {
+        for (const uint16_t old_word : edges) {
+            for (const uint16_t new_word : edges) {
+                if (other == 0 and new_word == 0) {
+                    continue;
+                }
+                string data(4, 0);
+                set_word(data, 0, other);
+                set_word(data, 2, old_word);
+                const uint16_t cksum = reference_checksum(data, 0);
+                set_word(data, 2, new_word);
+                if (InternetChecksum::update(cksum, old_word, new_word) != reference_checksum(data, 0)) {
+                    throw runtime_error("InternetChecksum::update disagrees with a full recomputation when "
+                                        + to_string(old_word) + " next to " + to_string(other) + " becomes "
+                                        + to_string(new_word));
+                }
+            }
+        }
+    }
+}
+} // namespace
+
+int main() {
+    try {
+        auto rd = get_random_engine();
+        split_test(rd);
+        alignment_test(rd);
+        edge_test();
+        incremental_update_test(rd);
+        incremental_update_edge_test();
+    } catch (const exception& e) {
+        cerr << "Exception: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
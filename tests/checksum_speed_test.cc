@@ -0,0 +1,79 @@
+#include "checksum.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+string random_string(default_random_engine& rd, size_t len) {
+    uniform_int_distribution<char> ud;
+    string ret;
+    for (size_t i = 0; i < len; ++i) {
+        ret += ud(rd);
+    }
+    return ret;
+}
+
+void speed_test(const size_t total_len,  // NOLINT(bugprone-easily-swappable-parameters)
+                const size_t buffer_len, // NOLINT(bugprone-easily-swappable-parameters)
+                const size_t random_seed)
+{
+    default_random_engine rd {random_seed};
+    vector<string> buffers;
+    for (size_t i = 0; i < 64; ++i) {
+        buffers.push_back(random_string(rd, buffer_len));
+    }
+
+    const size_t rounds = total_len / buffer_len;
+    uint32_t sink = 0;
+
+    const auto start_time = steady_clock::now();
+    for (size_t i = 0; i < rounds; ++i) {
+        InternetChecksum check;
+        check.add(buffers[i % buffers.size()]);
+        sink += check.value();
+    }
+    const auto stop_time = steady_clock::now();
+
+    auto test_duration = duration_cast<duration<double>>(stop_time - start_time);
+    auto bytes_per_second = static_cast<double>(rounds * buffer_len) / test_duration.count();
+    auto bits_per_second = 8 * bytes_per_second;
+    auto gigabits_per_second = bits_per_second / 1e9;
+
+    fstream debug_output;
+    debug_output.open("/dev/tty");
+
+    cout << "InternetChecksum over " << buffer_len << "-byte buffers reached " << fixed << setprecision(2)
+         << gigabits_per_second << " Gbit/s (check " << sink % 10 << ").\n";
+
+    debug_output << "        InternetChecksum throughput: " << fixed << setprecision(2) << gigabits_per_second
+                 << " Gbit/s\n";
+
+    if (gigabits_per_second < 0.1) {
+        throw runtime_error("InternetChecksum did not meet minimum speed of 0.1 Gbit/s.");
+    }
+}
+
+void program_body() {
+    speed_test(1e9, 20, 1234);
+    speed_test(1e9, 1500, 1234);
+    speed_test(1e9, 65536, 1234);
+}
+
+int main() {
+    try {
+        program_body();
+    } catch (const exception& e) {
+        cerr << "Exception: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
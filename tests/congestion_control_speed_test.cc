@@ -0,0 +1,220 @@
+#include "congestion_control.hh"
+#include "tcp_config.hh"
+#include "tcp_receiver.hh"
+#include "tcp_sender.hh"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+
+using namespace std;
+using namespace std::chrono;
+
+// A deterministic, millisecond-stepped simulation of one bulk transfer over a bottleneck link with a drop-tail
+// queue, a fixed propagation delay and random loss. Acks come back over a loss-free path.
+struct Path {
+    uint64_t bytes_per_ms;
+    uint64_t one_way_delay_ms;
+    uint64_t queue_bytes;
+    double loss_rate;
+};
+
+struct Result {
+    double goodput_mbps;
+    uint64_t segments_sent;
+    uint64_t segments_dropped;
+    uint64_t segments_redundant; // arrived with nothing the receiver did not hold already
+};
+
+constexpr uint64_t HEADER_BYTES = 40;
+
+Result simulate(const CongestionControl algorithm,
+                const Path& path,
+                const uint64_t duration_ms,
+                const size_t seed,
+                const bool sack,
+                const bool pacing = false)
+{
+    default_random_engine rd {seed};
+    bernoulli_distribution lost {path.loss_rate};
+
+    TCPConfig cfg;
+    TCPSender sender {ByteStream {cfg.send_capacity},
+                      cfg.isn,
+                      cfg.rt_timeout,
+                      TCPSender::RTOBounds {cfg.rt_timeout_min, cfg.rt_timeout_max},
+                      make_congestion_controller(algorithm, TCPConfig::MAX_PAYLOAD_SIZE)};
+    TCPReceiver receiver {Reassembler {ByteStream {TCPConfig::DEFAULT_CAPACITY}}};
+    if (pacing) {
+        sender.enable_pacing();
+    }
+
+    deque<TCPSenderMessage> bottleneck_queue;
+    uint64_t queued_bytes = 0;
+    uint64_t link_credit = 0;
+    deque<pair<uint64_t, TCPSenderMessage>> forward_path;
+    deque<pair<uint64_t, TCPReceiverMessage>> reverse_path;
+
+    Result result {};
+    const auto transmit = [&](TCPSenderMessage msg) {
+        ++result.segments_sent;
+        msg.SACK_permitted &= sack;
+        const uint64_t size = msg.payload.size() + HEADER_BYTES;
+        if (lost(rd) or queued_bytes + size > path.queue_bytes) {
+            ++result.segments_dropped;
+            return;
+        }
+        queued_bytes += size;
+        bottleneck_queue.push_back(move(msg));
+    };
+
+    const string data(cfg.send_capacity, 'x');
+    uint64_t bytes_delivered = 0;
+
+    for (uint64_t now = 0; now < duration_ms; ++now) {
+        /* acks arriving at the sender */
+        while (not reverse_path.empty() and reverse_path.front().first <= now) {
+            sender.receive(reverse_path.front().second);
+            reverse_path.pop_front();
+        }
+
+        /* the bottleneck serializes what its rate allows this millisecond */
+        link_credit += path.bytes_per_ms;
+        while (not bottleneck_queue.empty()
+               and bottleneck_queue.front().payload.size() + HEADER_BYTES <= link_credit) {
+            const uint64_t size = bottleneck_queue.front().payload.size() + HEADER_BYTES;
+            link_credit -= size;
+            queued_bytes -= size;
+            forward_path.emplace_back(now + path.one_way_delay_ms, move(bottleneck_queue.front()));
+            bottleneck_queue.pop_front();
+        }
+        if (bottleneck_queue.empty()) {
+            link_credit = 0;
+        }
+
+        /* segments arriving at the receiver, each acked */
+        while (not forward_path.empty() and forward_path.front().first <= now) {
+            const uint64_t held = receiver.writer().bytes_pushed() + receiver.reassembler().bytes_pending();
+            const bool has_payload = not forward_path.front().second.payload.empty();
+            receiver.receive(move(forward_path.front().second));
+            if (has_payload and receiver.writer().bytes_pushed() + receiver.reassembler().bytes_pending() == held) {
+                ++result.segments_redundant;
+            }
+            forward_path.pop_front();
+            reverse_path.emplace_back(now + path.one_way_delay_ms, receiver.send());
+        }
+
+        /* the application drains the receiver and keeps the sender's stream full */
+        bytes_delivered += receiver.reader().bytes_buffered();
+        receiver.reader().pop(receiver.reader().bytes_buffered());
+        sender.writer().push(data.substr(0, sender.writer().available_capacity()));
+
+        sender.push(transmit);
+        sender.tick(1, transmit);
+    }
+
+    result.goodput_mbps = static_cast<double>(bytes_delivered) * 8 / static_cast<double>(duration_ms) / 1000;
+    return result;
+}
+
+void comparison(const Path& path, const uint64_t duration_ms, const size_t seed) {
+    fstream debug_output;
+    debug_output.open("/dev/tty");
+
+    const double link_mbps = static_cast<double>(path.bytes_per_ms) * 8 / 1000;
+    cout << "Simulated " << fixed << setprecision(0) << link_mbps << " Mbit/s link, " << 2 * path.one_way_delay_ms
+         << " ms RTT, " << path.queue_bytes << "-byte queue, " << duration_ms / 1000 << " s per run:\n";
+
+    const auto run = [&](const CongestionControl algorithm, const Path& lossy, const bool sack) {
+        const auto start_time = steady_clock::now();
+        const auto result = simulate(algorithm, lossy, duration_ms, seed, sack);
+        const auto test_duration = duration_cast<duration<double>>(steady_clock::now() - start_time);
+
+        cout << "  loss " << setw(4) << setprecision(1) << lossy.loss_rate * 100 << "%  " << setw(5)
+             << to_string(algorithm) << "  goodput " << setw(5) << setprecision(2) << result.goodput_mbps
+             << " Mbit/s  (" << result.segments_sent << " segments sent, " << result.segments_dropped
+             << " dropped, " << result.segments_redundant << " redundant; simulated in " << setprecision(2)
+             << test_duration.count() << " s)\n";
+        return result;
+    };
+
+    for (const double loss_rate : {0.0, 0.001, 0.01, 0.05}) {
+        Path lossy = path;
+        lossy.loss_rate = loss_rate;
+        for (const auto algorithm :
+             {CongestionControl::None, CongestionControl::Reno, CongestionControl::Cubic, CongestionControl::BBR}) {
+            const auto result = run(algorithm, lossy, true);
+            if (algorithm != CongestionControl::None and loss_rate == 0 and result.goodput_mbps < link_mbps / 2) {
+                throw runtime_error("Congestion control " + string {to_string(algorithm)}
+                                    + " did not reach half the link rate on a loss-free path.");
+            }
+        }
+    }
+
+    cout << "Without SACK:\n";
+    for (const double loss_rate : {0.01, 0.05}) {
+        Path lossy = path;
+        lossy.loss_rate = loss_rate;
+        for (const auto algorithm : {CongestionControl::Reno, CongestionControl::Cubic, CongestionControl::BBR}) {
+            run(algorithm, lossy, false);
+        }
+    }
+
+    debug_output << "   Congestion control comparison: done\n";
+}
+
+void pacing_comparison(const Path& path, const uint64_t duration_ms, const size_t seed) {
+    fstream debug_output;
+    debug_output.open("/dev/tty");
+
+    /* BBR always paces (see CongestionController::needs_pacing) */
+    cout << "With a " << path.queue_bytes << "-byte queue, in bursts and paced:\n";
+    for (const auto algorithm : {CongestionControl::Reno, CongestionControl::Cubic}) {
+        array<Result, 2> results {};
+        for (const bool pacing : {false, true}) {
+            const auto start_time = steady_clock::now();
+            const auto result = simulate(algorithm, path, duration_ms, seed, true, pacing);
+            const auto test_duration = duration_cast<duration<double>>(steady_clock::now() - start_time);
+            results.at(pacing) = result;
+
+            cout << "  " << setw(5) << to_string(algorithm) << (pacing ? "  paced " : "  bursts") << "  goodput "
+                 << setw(5) << setprecision(2) << result.goodput_mbps << " Mbit/s  (" << result.segments_sent
+                 << " segments sent, " << result.segments_dropped << " dropped; simulated in "
+                 << setprecision(2) << test_duration.count() << " s)\n";
+        }
+
+        if (results[1].goodput_mbps < results[0].goodput_mbps) {
+            throw runtime_error("Pacing " + string {to_string(algorithm)} + " lost goodput at a shallow queue.");
+        }
+    }
+
+    const auto bbr = simulate(CongestionControl::BBR, path, duration_ms, seed, true);
+    cout << "  " << setw(5) << to_string(CongestionControl::BBR) << "  paced   goodput " << setw(5)
+         << setprecision(2) << bbr.goodput_mbps << " Mbit/s  (" << bbr.segments_sent << " segments sent, "
+         << bbr.segments_dropped << " dropped)\n";
+
+    debug_output << "   Pacing comparison: done\n";
+}
+
+void program_body() {
+    comparison({1250, 10, 25000, 0}, 30000, 1370);
+    pacing_comparison({1250, 10, 2500, 0}, 30000, 1370);
+}
+
+int main() {
+    try {
+        program_body();
+    } catch (const exception& e) {
+        cerr << "Exception: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,207 @@
+#include "exception.hh"
+#include "tcp_demux.hh"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <vector>
+
+using namespace std;
+
+// A demultiplexer, and the other end of its socket, where the network takes and leaves its datagrams
+struct Host {
+    TCPOverIPv4Demultiplexer demux;
+    FileDescriptor wire;
+
+    static Host make() {
+        array<int, 2> fds {};
+        CheckSystemCall("socketpair", ::socketpair(AF_UNIX, SOCK_DGRAM, 0, fds.data()));
+        Host host {TCPOverIPv4Demultiplexer {FileDescriptor {fds[0]}, 1500}, FileDescriptor {fds[1]}};
+        host.wire.set_blocking(false);
+        return host;
+    }
+};
+
+// A client and a request/response server, joined by a link with a fixed delay, in simulated time
+class Network {
+  public:
+    static constexpr uint64_t ONE_WAY_DELAY_MS = 10;
+    static constexpr uint64_t RTT_MS = 2 * ONE_WAY_DELAY_MS;
+    static constexpr uint64_t TIMEOUT_MS = 100 * RTT_MS;
+
+    static inline const string REQUEST = "GET / HTTP/1.1\r\nHost: 169.254.144.9\r\n\r\n";
+    static inline const string RESPONSE = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+
+    explicit Network(bool server_fast_open) {
+        TCPConfig tcp_config;
+        tcp_config.fast_open = server_fast_open;
+        ListenerConfig listener_config;
+        listener_config.local = server_address();
+        listener_ = server_.demux.listen(tcp_config, listener_config);
+    }
+
+    static Address server_address() { return Address {"169.254.144.9", 80}; }
+
+    // Open a connection, send the request, and wait for the first byte of the response
+    // \returns the time that took
+    uint64_t first_byte_ms(bool fast_open) {
+        TCPConfig tcp_config;
+        tcp_config.fast_open = fast_open;
+        FdAdapterConfig adapter_config;
+        adapter_config.source = Address {"169.254.144.1", next_port_++};
+        adapter_config.destination = server_address();
+
+        const uint64_t start_ms = now_ms_;
+        const auto connection = client_.demux.connect(tcp_config, adapter_config, REQUEST);
+        transmit();
+        while (client_.demux.peer(connection).inbound_reader().bytes_buffered() == 0) {
+            if (now_ms_ - start_ms > TIMEOUT_MS) {
+                throw runtime_error("no response within " + to_string(TIMEOUT_MS) + " ms");
+            }
+            step();
+        }
+        if (client_.demux.peer(connection).inbound_reader().peek().front() != RESPONSE.front()) {
+            throw runtime_error("the response is corrupt");
+        }
+        client_.demux.erase(connection);
+        return now_ms_ - start_ms;
+    }
+
+  private:
+    struct InFlight {
+        uint64_t arrival_ms;
+        bool to_server;
+        string datagram;
+    };
+
+    // One millisecond: deliver what has crossed the link, answer requests, and send what the hosts wrote
+    void step() {
+        ++now_ms_;
+        client_.demux.tick(1);
+        server_.demux.tick(1);
+
+        while (not link_.empty() and link_.front().arrival_ms <= now_ms_) {
+            auto& host = link_.front().to_server ? server_ : client_;
+            host.demux.receive(vector<string> {move(link_.front().datagram)});
+            link_.pop_front();
+        }
+
+        while (const auto accepted = server_.demux.accept(listener_)) {
+            serving_.push_back(accepted.value());
+        }
+        for (size_t i = 0; i < serving_.size();) {
+            auto& peer = server_.demux.peer(serving_[i]);
+            if (peer.inbound_reader().bytes_buffered() < REQUEST.size()) {
+                ++i;
+                continue;
+            }
+            if (peer.inbound_reader().peek().substr(0, REQUEST.size()) != REQUEST) {
+                throw runtime_error("the request is corrupt");
+            }
+            peer.outbound_writer().push(RESPONSE);
+            server_.demux.push(serving_[i]);
+            server_.demux.erase(serving_[i]);
+            serving_[i] = serving_.back();
+            serving_.pop_back();
+        }
+
+        transmit();
+    }
+
+    // Put what the hosts wrote on the link
+    void transmit() {
+        for (const bool to_server : {true, false}) {
+            auto& wire = to_server ? client_.wire : server_.wire;
+            while (true) {
+                string datagram;
+                wire.read(datagram);
+                if (datagram.empty()) {
+                    break;
+                }
+                link_.push_back({now_ms_ + ONE_WAY_DELAY_MS, to_server, move(datagram)});
+            }
+        }
+    }
+
+    Host client_ = Host::make();
+    Host server_ = Host::make();
+    size_t listener_ {};
+    vector<size_t> serving_ {};
+    deque<InFlight> link_ {};
+    uint64_t now_ms_ {};
+    uint16_t next_port_ = 1024;
+};
+
+double mean_first_byte_ms(Network& network, bool fast_open, size_t connections) {
+    uint64_t total_ms = 0;
+    for (size_t i = 0; i < connections; ++i) {
+        total_ms += network.first_byte_ms(fast_open);
+    }
+    return static_cast<double>(total_ms) / static_cast<double>(connections);
+}
+
+void latency_test(const size_t connections) {
+    constexpr auto rtt = static_cast<double>(Network::RTT_MS);
+    const auto server = Network::server_address().ipv4_numeric();
+    Network network {true};
+
+    const double plain_ms = mean_first_byte_ms(network, false, connections);
+    const double request_ms = network.first_byte_ms(true); // no cookie yet: the SYN asks for one
+    const double fast_open_ms = mean_first_byte_ms(network, true, connections);
+
+    // a server that rejects the cookie takes the request after the handshake, and issues a valid cookie
+    FastOpenCookies::cache(server, "stale cookie");
+    const double invalid_ms = network.first_byte_ms(true);
+    const double reissued_ms = network.first_byte_ms(true);
+
+    // as does a server without Fast Open, whatever the client sends
+    Network plain_server {false};
+    const double disabled_ms = mean_first_byte_ms(plain_server, true, connections);
+
+    fstream debug_output;
+    debug_output.open("/dev/tty");
+
+    cout << fixed << setprecision(1) << "Connection to first response byte, over a " << rtt << " ms RTT:\n"
+         << "    without Fast Open:             " << plain_ms << " ms\n"
+         << "    requesting a cookie:           " << request_ms << " ms\n"
+         << "    with a cookie:                 " << fast_open_ms << " ms\n"
+         << "    with an invalid cookie:        " << invalid_ms << " ms (then " << reissued_ms << " ms)\n"
+         << "    to a server without Fast Open: " << disabled_ms << " ms\n";
+
+    debug_output << "      Fast Open first-byte latency: " << fixed << setprecision(1) << fast_open_ms / rtt
+                 << " RTT (without: " << plain_ms / rtt << " RTT)\n";
+
+    if (fast_open_ms > 1.5 * rtt or fast_open_ms >= plain_ms) {
+        throw runtime_error("Fast Open did not save the handshake's round trip");
+    }
+    if (reissued_ms > 1.5 * rtt) {
+        throw runtime_error("the cookie reissued after an invalid one was not used");
+    }
+    for (const double ms : {plain_ms, request_ms, invalid_ms, disabled_ms}) {
+        if (ms < 1.5 * rtt) {
+            throw runtime_error("data was accepted on a SYN without a valid cookie");
+        }
+    }
+}
+
+void program_body() {
+    latency_test(1000);
+}
+
+int main() {
+    try {
+        program_body();
+    } catch (const exception& e) {
+        cerr << "Exception: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,123 @@
+#include "address.hh"
+#include "forwarding_table_common.hh"
+#include "random.hh"
+#include "router.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+// The longest match by a linear scan (the previous implementation); among equal prefixes the last one wins
+optional<uint32_t> linear_lookup(const vector<Prefix>& prefixes, uint32_t address) {
+    optional<uint32_t> ret;
+    int best_length = -1;
+    for (size_t j = 0; j < prefixes.size(); ++j) {
+        const auto [prefix, len] = prefixes[j];
+        if (len >= best_length and (len == 0 or ((address ^ prefix) >> (32 - len)) == 0)) {
+            ret = j;
+            best_length = len;
+        }
+    }
+    return ret;
+}
+
+ForwardingTable table_of(const vector<Prefix>& prefixes) {
+    ForwardingTable table;
+    for (size_t i = 0; i < prefixes.size(); ++i) {
+        table.add(get<0>(prefixes[i]), get<1>(prefixes[i]), i);
+    }
+    return table;
+}
+
+uint32_t ip(const string& address) {
+    return Address {address}.ipv4_numeric();
+}
+
+void expect_route(const ForwardingTable& table, const string& address, optional<uint32_t> route) {
+    if (table.lookup(ip(address)) != route) {
+        throw runtime_error("lookup of " + address + " gave "
+                            + (table.lookup(ip(address)) ? to_string(table.lookup(ip(address)).value()) : "none")
+                            + ", expected " + (route ? to_string(route.value()) : "none"));
+    }
+}
+
+// Compare against a linear scan on a random table small enough to scan
+void random_test(default_random_engine& rd) {
+    const auto prefixes = random_prefixes(rd, 2000);
+    const auto table = table_of(prefixes);
+
+    for (size_t i = 0; i < 20000; ++i) {
+        // aim at known prefixes half of the time, so most lookups match something
+        uint32_t address = rd();
+        if (i % 2) {
+            address = get<0>(prefixes[i % prefixes.size()]) | (address & 0xff);
+        }
+        if (table.lookup(address) != linear_lookup(prefixes, address)) {
+            throw runtime_error("ForwardingTable lookup disagrees with a linear scan");
+        }
+    }
+}
+
+// A default route, host routes, and prefixes nested across the trie's 8-bit strides, added longest first so
+// that shorter ones must not overwrite them
+void edge_test() {
+    const vector<Prefix> prefixes {
+      {ip("10.1.2.129"), 32},
+      {ip("10.1.2.128"), 25},
+      {ip("10.1.2.0"), 24},
+      {ip("10.1.0.0"), 16},
+      {ip("10.0.0.0"), 7},
+      {ip("10.0.0.0"), 8},
+      {ip("0.0.0.0"), 0},
+      {ip("255.255.255.255"), 32},
+      {ip("10.1.0.0"), 16}, // the same prefix again: it replaces the first
+    };
+    const auto table = table_of(prefixes);
+
+    expect_route(table, "10.1.2.129", 0);
+    expect_route(table, "10.1.2.130", 1);
+    expect_route(table, "10.1.2.127", 2);
+    expect_route(table, "10.1.3.1", 8);
+    expect_route(table, "10.2.0.0", 5);
+    expect_route(table, "11.0.0.1", 4);
+    expect_route(table, "12.0.0.1", 6);
+    expect_route(table, "255.255.255.255", 7);
+    expect_route(table, "255.255.255.254", 6);
+
+    for (const auto& address : {"0.0.0.0", "10.1.2.128", "10.1.2.255", "10.255.255.255", "128.0.0.0"}) {
+        if (table.lookup(ip(address)) != linear_lookup(prefixes, ip(address))) {
+            throw runtime_error(string {"lookup of "} + address + " disagrees with a linear scan");
+        }
+    }
+
+    // without a default route, an address no prefix covers has no route
+    ForwardingTable hosts;
+    hosts.add(ip("192.168.0.1"), 32, 0);
+    expect_route(hosts, "192.168.0.1", 0);
+    expect_route(hosts, "192.168.0.0", nullopt);
+    expect_route(ForwardingTable {}, "192.168.0.1", nullopt);
+}
+} // namespace
+
+int main() {
+    try {
+        auto rd = get_random_engine();
+        edge_test();
+        random_test(rd);
+    } catch (const exception& e) {
+        cerr << "Exception: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <tuple>
+#include <vector>
+
+using Prefix = std::tuple<uint32_t, uint8_t>;
+
+// Prefix lengths roughly shaped like a real BGP table: mostly /24, a long tail of /16../23, a few of the rest
+inline std::vector<Prefix> random_prefixes(std::default_random_engine& rd, size_t count) {
+    std::discrete_distribution<int> length_dist {
+      {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 40, 10, 20, 30, 40, 70, 90, 550, 5, 5, 5, 5, 5, 5, 5, 5, 5}};
+    std::vector<Prefix> ret;
+    ret.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        const auto len = static_cast<uint8_t>(length_dist(rd));
+        const uint32_t mask = len == 0 ? 0 : ~uint32_t {} << (32 - len);
+        ret.emplace_back(static_cast<uint32_t>(rd()) & mask, len);
+    }
+    return ret;
+}
@@ -0,0 +1,158 @@
+#include "random.hh"
+#include "tcp_config.hh"
+#include "tcp_peer.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+// A client and a server TCPPeer, and the segments each has sent and the other not yet received
+class PeerPair {
+  public:
+    explicit PeerPair(const TCPConfig& cfg) : client_(cfg), server_(cfg), isn_(cfg.isn) {
+        client_.push(to_server());
+        deliver_to_server(); // SYN
+        deliver_to_client(); // SYN-ACK
+        deliver_to_server(); // ACK
+        if (not to_client_.empty() or not to_server_.empty()) {
+            throw runtime_error("the handshake left segments behind");
+        }
+    }
+
+    TCPPeer& client() { return client_; }
+    TCPPeer& server() { return server_; }
+
+    // Send `data` from the client; it goes out in as many segments as the MSS requires
+    void send(const string& data) {
+        client_.outbound_writer().push(data);
+        client_.push(to_server());
+    }
+
+    void close() {
+        client_.outbound_writer().close();
+        client_.push(to_server());
+    }
+
+    size_t in_flight_to_server() const { return to_server_.size(); }
+
+    // Deliver the oldest segment in flight to the server
+    void deliver_to_server() { deliver(to_server_, server_, to_client()); }
+    void deliver_to_client() { deliver(to_client_, client_, to_server()); }
+
+    // Lose the oldest segment in flight to the server
+    void drop_to_server() { to_server_.pop_front(); }
+
+    void tick_server(uint64_t ms) { server_.tick(ms, to_client()); }
+
+    // Expect exactly `count` ACKs from the server, the last acknowledging `bytes` of client data
+    void expect_acks(const string& step, size_t count, uint64_t bytes = 0) {
+        if (to_client_.size() != count) {
+            throw runtime_error(step + ": expected " + to_string(count) + " ACK(s) from the server, but it sent "
+                                + to_string(to_client_.size()));
+        }
+        if (count > 0 and to_client_.back().receiver.ackno != isn_ + 1 + bytes) {
+            throw runtime_error(step + ": the ACK did not acknowledge " + to_string(bytes) + " bytes");
+        }
+        to_client_.clear();
+    }
+
+  private:
+    static void deliver(deque<TCPMessage>& queue, TCPPeer& peer, const TCPPeer::TransmitFunction& transmit) {
+        if (queue.empty()) {
+            throw runtime_error("no segment to deliver");
+        }
+        auto msg = move(queue.front());
+        queue.pop_front();
+        peer.receive(move(msg), transmit);
+    }
+
+    TCPPeer::TransmitFunction to_server() {
+        return [this](TCPMessage msg) { to_server_.push_back(move(msg)); };
+    }
+    TCPPeer::TransmitFunction to_client() {
+        return [this](TCPMessage msg) { to_client_.push_back(move(msg)); };
+    }
+
+    TCPPeer client_;
+    TCPPeer server_;
+    Wrap32 isn_;
+    deque<TCPMessage> to_server_ {};
+    deque<TCPMessage> to_client_ {};
+};
+
+int main() {
+    try {
+        auto rd = get_random_engine();
+        TCPConfig cfg;
+        cfg.isn = Wrap32 {static_cast<uint32_t>(rd())};
+        const uint64_t mss = cfg.mss;
+        const uint64_t timeout = cfg.delayed_ack_timeout;
+
+        {
+            PeerPair peers {cfg};
+            peers.send(string(4 * mss, 'x'));
+            for (uint64_t i = 1; i <= 4; ++i) {
+                peers.deliver_to_server();
+                peers.expect_acks("every second full-sized segment", i % 2 == 0 ? 1 : 0, i * mss);
+            }
+        }
+
+        {
+            PeerPair peers {cfg};
+            peers.send(string(mss, 'x'));
+            peers.deliver_to_server();
+            peers.expect_acks("one full-sized segment", 0);
+            peers.tick_server(timeout - 1);
+            peers.expect_acks("before the delayed-ACK timeout", 0);
+            peers.tick_server(1);
+            peers.expect_acks("at the delayed-ACK timeout", 1, mss);
+            peers.tick_server(10 * timeout);
+            peers.expect_acks("after the delayed ACK", 0);
+        }
+
+        {
+            PeerPair peers {cfg};
+            peers.send(string(mss, 'x'));
+            peers.deliver_to_server();
+            peers.send(string(mss / 2, 'y'));
+            peers.deliver_to_server();
+            peers.expect_acks("a smaller segment does not count as full-sized", 0);
+            peers.tick_server(timeout);
+            peers.expect_acks("the timer runs from the first unacknowledged segment", 1, mss + mss / 2);
+        }
+
+        {
+            PeerPair peers {cfg};
+            peers.send(string(3 * mss, 'x'));
+            peers.drop_to_server();
+            peers.deliver_to_server();
+            peers.expect_acks("out-of-order data", 1, 0);
+            peers.deliver_to_server();
+            peers.expect_acks("more out-of-order data", 1, 0);
+        }
+
+        {
+            PeerPair peers {cfg};
+            peers.send(string(mss, 'x'));
+            peers.close();
+            if (peers.in_flight_to_server() != 2) {
+                throw runtime_error("the data and the FIN should have gone out separately");
+            }
+            peers.deliver_to_server();
+            peers.expect_acks("data before the FIN", 0);
+            peers.deliver_to_server();
+            peers.expect_acks("FIN", 1, mss + 1);
+        }
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
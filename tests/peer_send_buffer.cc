@@ -0,0 +1,74 @@
+#include "random.hh"
+#include "tcp_config.hh"
+#include "tcp_peer.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace {
+// The bytes in flight stay retained in the sender's stream, so with a fixed send buffer a peer could never have
+// more than its capacity in flight. A peer with the default config grows the buffer to fill a larger window.
+void fills_large_window(default_random_engine& rd) {
+    TCPConfig client_cfg;
+    client_cfg.isn = Wrap32 {static_cast<uint32_t>(rd())};
+    TCPConfig server_cfg;
+    server_cfg.isn = Wrap32 {static_cast<uint32_t>(rd())};
+    server_cfg.recv_capacity = 1 << 20;
+
+    TCPPeer client {client_cfg};
+    TCPPeer server {server_cfg};
+    deque<TCPMessage> to_server;
+    deque<TCPMessage> to_client;
+    const TCPPeer::TransmitFunction send_to_server = [&](TCPMessage msg) { to_server.push_back(move(msg)); };
+    const TCPPeer::TransmitFunction send_to_client = [&](TCPMessage msg) { to_client.push_back(move(msg)); };
+
+    uint64_t most_in_flight = 0;
+    client.push(send_to_server);
+    for (size_t round = 0; round < 12; ++round) {
+        auto& writer = client.outbound_writer();
+        writer.push(string(writer.available_capacity(), 'x'));
+        client.push(send_to_server);
+        most_in_flight = max(most_in_flight, client.sender().sequence_numbers_in_flight());
+
+        // one round trip: everything in flight arrives, and every ACK returns
+        for (; not to_server.empty(); to_server.pop_front()) {
+            server.receive(move(to_server.front()), send_to_client);
+        }
+        server.tick(server_cfg.delayed_ack_timeout, send_to_client);
+        for (; not to_client.empty(); to_client.pop_front()) {
+            client.receive(move(to_client.front()), send_to_server);
+        }
+    }
+
+    if (most_in_flight <= TCPConfig::DEFAULT_CAPACITY) {
+        throw runtime_error("a default-config peer had at most " + to_string(most_in_flight)
+                            + " bytes in flight, within its initial send buffer");
+    }
+    if (client.sender().writer().capacity() > client_cfg.send_capacity_max) {
+        throw runtime_error("the send buffer grew beyond send_capacity_max");
+    }
+    if (server.inbound_reader().bytes_buffered() < most_in_flight) {
+        throw runtime_error("the server did not receive what was in flight");
+    }
+}
+} // namespace
+
+int main() {
+    try {
+        auto rd = get_random_engine();
+        fills_large_window(rd);
+    } catch (const exception& e) {
+        cerr << "Exception: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
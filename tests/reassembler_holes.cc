@@ -2,6 +2,7 @@
 
 #include <exception>
 #include <iostream>
+#include <string>
 
 using namespace std;
 
@@ -128,6 +129,58 @@ int main() {
             test.execute(ReadAll(""));
             test.execute(IsFinished {true});
         }
+
+        for (const auto storage : {Reassembler::Storage::IntervalMap, Reassembler::Storage::Bitmap}) {
+            ReassemblerTestHarness test {"in-order bytes around a hole", 8, storage};
+
+            /* in order with nothing pending, then a hole, then in order again */
+            test.execute(Insert {"abc", 0});
+            test.execute(BytesPushed(3));
+            test.execute(Insert {"fg", 5});
+            test.execute(BytesPending(2));
+            test.execute(Insert {"de", 3});
+            test.execute(BytesPushed(7));
+            test.execute(BytesPending(0));
+            test.execute(ReadAll("abcdefg"));
+
+            /* a partly old, partly too long in-order segment is trimmed to the window */
+            test.execute(Insert {"fghijklmnopq", 5});
+            test.execute(BytesPushed(15));
+            test.execute(PendingRanges {{}});
+            test.execute(ReadAll("hijklmno"));
+            test.execute(Insert {"pq", 15}.is_last());
+            test.execute(ReadAll("pq"));
+            test.execute(IsFinished {true});
+        }
+
+        for (const auto storage : {Reassembler::Storage::IntervalMap, Reassembler::Storage::Bitmap}) {
+            ReassemblerTestHarness test {"pending ranges", 65000, storage};
+
+            test.execute(PendingRanges {{}});
+            test.execute(Insert {"cd", 2});
+            test.execute(Insert {"ef", 4});
+            test.execute(Insert {"ij", 8});
+            test.execute(PendingRanges {{{2, 6}, {8, 10}}});
+
+            test.execute(Insert {"gh", 6});
+            test.execute(PendingRanges {{{2, 10}}});
+
+            test.execute(Insert {"ab", 0});
+            test.execute(PendingRanges {{}});
+            test.execute(ReadAll("abcdefghij"));
+        }
+
+        for (const auto storage : {Reassembler::Storage::IntervalMap, Reassembler::Storage::Bitmap}) {
+            ReassemblerTestHarness test {"pending ranges across the end of the buffer", 70, storage};
+
+            test.execute(Insert {string(100, 'x'), 0});
+            test.execute(ReadAll(string(70, 'x')));
+            test.execute(Insert {string(30, 'x'), 70});
+            test.execute(ReadAll(string(30, 'x')));
+            test.execute(Insert {string(20, 'y'), 120});
+            test.execute(Insert {"z", 165});
+            test.execute(PendingRanges {{{120, 140}, {165, 166}}});
+        }
     } catch (const exception& e) {
         cerr << "Exception: " << e.what() << endl;
         return EXIT_FAILURE;
@@ -13,9 +13,14 @@
 using namespace std;
 using namespace std::chrono;
 
+string storage_name(const Reassembler::Storage storage) {
+    return storage == Reassembler::Storage::Bitmap ? "bitmap" : "interval map";
+}
+
 void speed_test(const size_t num_chunks,  // NOLINT(bugprone-easily-swappable-parameters)
                 const size_t capacity,    // NOLINT(bugprone-easily-swappable-parameters)
-                const size_t random_seed) // NOLINT(bugprone-easily-swappable-parameters)
+                const size_t random_seed, // NOLINT(bugprone-easily-swappable-parameters)
+                const Reassembler::Storage storage)
 {
     // Generate the data to be written
     const string data = [&] {
@@ -36,7 +41,7 @@ void speed_test(const size_t num_chunks,  // NOLINT(bugprone-easily-swappable-pa
         split_data.emplace(i + 1, data.substr(i + 1, capacity * 2), i + 1 + capacity * 2 >= data.size());
     }
 
-    Reassembler reassembler {ByteStream {capacity}};
+    Reassembler reassembler {ByteStream {capacity}, storage};
 
     string output_data;
     output_data.reserve(data.size());
@@ -71,8 +76,8 @@ void speed_test(const size_t num_chunks,  // NOLINT(bugprone-easily-swappable-pa
     fstream debug_output;
     debug_output.open("/dev/tty");
 
-    cout << "Reassembler to ByteStream with capacity=" << capacity << " reached " << fixed << setprecision(2)
-         << gigabits_per_second << " Gbit/s.\n";
+    cout << "Reassembler (" << storage_name(storage) << ") to ByteStream with capacity=" << capacity
+         << " reached " << fixed << setprecision(2) << gigabits_per_second << " Gbit/s.\n";
 
     debug_output << "             Reassembler throughput: " << fixed << setprecision(2) << gigabits_per_second
                  << " Gbit/s\n";
@@ -82,8 +87,167 @@ void speed_test(const size_t num_chunks,  // NOLINT(bugprone-easily-swappable-pa
     }
 }
 
+// Lossy-link pattern: each window arrives as many small overlapping pieces, out of order and with holes,
+// before the retransmission that fills it. bytes_pending() is polled after every insert.
+void overlap_speed_test(const size_t num_chunks,       // NOLINT(bugprone-easily-swappable-parameters)
+                        const size_t capacity,         // NOLINT(bugprone-easily-swappable-parameters)
+                        const size_t random_seed,      // NOLINT(bugprone-easily-swappable-parameters)
+                        const size_t pieces_per_chunk, // NOLINT(bugprone-easily-swappable-parameters)
+                        const Reassembler::Storage storage)
+{
+    default_random_engine rd {random_seed};
+
+    // Generate the data to be written
+    const string data = [&] {
+        uniform_int_distribution<char> ud;
+        string ret;
+        for (size_t i = 0; i < num_chunks * capacity; ++i) {
+            ret += ud(rd);
+        }
+        return ret;
+    }();
+
+    // Split each window into random overlapping pieces (skipping its first byte, so nothing is deliverable
+    // until the whole window arrives)
+    queue<tuple<uint64_t, string, bool>> split_data;
+    for (size_t i = 0; i < data.size(); i += capacity) {
+        for (size_t j = 0; j < pieces_per_chunk; ++j) {
+            const size_t offset = i + 1 + rd() % (capacity - 1);
+            const size_t len = min(1 + rd() % (capacity / 8), i + capacity - offset);
+            split_data.emplace(offset, data.substr(offset, len), false);
+        }
+        split_data.emplace(i, data.substr(i, capacity), i + capacity >= data.size());
+    }
+
+    Reassembler reassembler {ByteStream {capacity}, storage};
+
+    string output_data;
+    output_data.reserve(data.size());
+    uint64_t max_pending = 0;
+
+    const auto start_time = steady_clock::now();
+    while (not split_data.empty()) {
+        auto& next = split_data.front();
+        reassembler.insert(get<uint64_t>(next), move(get<string>(next)), get<bool>(next));
+        split_data.pop();
+        max_pending = max(max_pending, reassembler.bytes_pending());
+
+        while (reassembler.reader().bytes_buffered()) {
+            output_data += reassembler.reader().peek();
+            reassembler.reader().pop(output_data.size() - reassembler.reader().bytes_popped());
+        }
+    }
+
+    const auto stop_time = steady_clock::now();
+
+    if (not reassembler.reader().is_finished()) {
+        throw runtime_error("Reassembler did not close ByteStream when finished");
+    }
+
+    if (data != output_data) {
+        throw runtime_error("Mismatch between data written and read");
+    }
+
+    if (max_pending >= capacity) {
+        throw runtime_error("Reassembler reported more bytes pending than fit in the window");
+    }
+
+    auto test_duration = duration_cast<duration<double>>(stop_time - start_time);
+    auto bytes_per_second = static_cast<double>(num_chunks * capacity) / test_duration.count();
+    auto bits_per_second = 8 * bytes_per_second;
+    auto gigabits_per_second = bits_per_second / 1e9;
+
+    fstream debug_output;
+    debug_output.open("/dev/tty");
+
+    cout << "Reassembler (" << storage_name(storage) << ") with capacity=" << capacity << " and "
+         << pieces_per_chunk << " overlapping pieces per window reached " << fixed << setprecision(2)
+         << gigabits_per_second << " Gbit/s.\n";
+
+    debug_output << "  Reassembler (overlap) throughput: " << fixed << setprecision(2) << gigabits_per_second
+                 << " Gbit/s\n";
+
+    if (gigabits_per_second < 0.1) {
+        throw runtime_error("Reassembler did not meet minimum speed of 0.1 Gbit/s.");
+    }
+}
+
+// In-order arrivals, one segment at a time, as on a loss-free link
+void sequential_speed_test(const size_t num_segments, // NOLINT(bugprone-easily-swappable-parameters)
+                           const size_t segment_size, // NOLINT(bugprone-easily-swappable-parameters)
+                           const size_t capacity,     // NOLINT(bugprone-easily-swappable-parameters)
+                           const size_t random_seed,  // NOLINT(bugprone-easily-swappable-parameters)
+                           const Reassembler::Storage storage)
+{
+    // Generate the data to be written
+    const string data = [&] {
+        default_random_engine rd {random_seed};
+        uniform_int_distribution<char> ud;
+        string ret;
+        for (size_t i = 0; i < num_segments * segment_size; ++i) {
+            ret += ud(rd);
+        }
+        return ret;
+    }();
+
+    // Split the data into segments before writing
+    queue<tuple<uint64_t, string, bool>> split_data;
+    for (size_t i = 0; i < data.size(); i += segment_size) {
+        split_data.emplace(i, data.substr(i, segment_size), i + segment_size >= data.size());
+    }
+
+    Reassembler reassembler {ByteStream {capacity}, storage};
+
+    string output_data;
+    output_data.reserve(data.size());
+
+    const auto start_time = steady_clock::now();
+    while (not split_data.empty()) {
+        auto& next = split_data.front();
+        reassembler.insert(get<uint64_t>(next), move(get<string>(next)), get<bool>(next));
+        split_data.pop();
+
+        while (reassembler.reader().bytes_buffered()) {
+            output_data += reassembler.reader().peek();
+            reassembler.reader().pop(output_data.size() - reassembler.reader().bytes_popped());
+        }
+    }
+
+    const auto stop_time = steady_clock::now();
+
+    if (not reassembler.reader().is_finished()) {
+        throw runtime_error("Reassembler did not close ByteStream when finished");
+    }
+
+    if (data != output_data) {
+        throw runtime_error("Mismatch between data written and read");
+    }
+
+    auto test_duration = duration_cast<duration<double>>(stop_time - start_time);
+    auto bytes_per_second = static_cast<double>(data.size()) / test_duration.count();
+    auto bits_per_second = 8 * bytes_per_second;
+    auto gigabits_per_second = bits_per_second / 1e9;
+
+    fstream debug_output;
+    debug_output.open("/dev/tty");
+
+    cout << "Reassembler (" << storage_name(storage) << ") with capacity=" << capacity << " and " << segment_size
+         << "-byte in-order segments reached " << fixed << setprecision(2) << gigabits_per_second << " Gbit/s.\n";
+
+    debug_output << "Reassembler (in-order) throughput: " << fixed << setprecision(2) << gigabits_per_second
+                 << " Gbit/s\n";
+
+    if (gigabits_per_second < 0.1) {
+        throw runtime_error("Reassembler did not meet minimum speed of 0.1 Gbit/s.");
+    }
+}
+
 void program_body() {
-    speed_test(10000, 1500, 1370);
+    for (const auto storage : {Reassembler::Storage::IntervalMap, Reassembler::Storage::Bitmap}) {
+        speed_test(10000, 1500, 1370, storage);
+        overlap_speed_test(1000, 16384, 1370, 256, storage);
+        sequential_speed_test(100000, 1460, 64000, 1370, storage);
+    }
 }
 
 int main() {
@@ -7,6 +7,7 @@
 #include <optional>
 #include <sstream>
 #include <utility>
+#include <vector>
 
 template<std::derived_from<TestStep<ByteStream>> T>
 struct ReassemblerTestStep : public TestStep<Reassembler> {
@@ -24,10 +25,13 @@ struct ReassemblerTestStep : public TestStep<Reassembler> {
 
 class ReassemblerTestHarness : public TestHarness<Reassembler> {
   public:
-    ReassemblerTestHarness(std::string test_name, uint64_t capacity)
+    ReassemblerTestHarness(std::string test_name,
+                           uint64_t capacity,
+                           Reassembler::Storage storage = Reassembler::Storage::IntervalMap)
       : TestHarness(move(test_name),
-                    "capacity=" + std::to_string(capacity),
-                    {Reassembler {ByteStream {capacity}}}) {}
+                    "capacity=" + std::to_string(capacity)
+                      + (storage == Reassembler::Storage::Bitmap ? ", storage=bitmap" : ""),
+                    {Reassembler {ByteStream {capacity}, storage}}) {}
 
     template<std::derived_from<TestStep<ByteStream>> T>
     void execute(const T& test) {
@@ -43,6 +47,31 @@ struct BytesPending : public ConstExpectNumber<Reassembler, uint64_t> {
     uint64_t value(const Reassembler& r) const override { return r.bytes_pending(); }
 };
 
+struct PendingRanges : public Expectation<Reassembler> {
+    std::vector<std::pair<uint64_t, uint64_t>> ranges_;
+    explicit PendingRanges(std::vector<std::pair<uint64_t, uint64_t>> ranges) : ranges_(std::move(ranges)) {}
+
+    static std::string to_string(const std::vector<std::pair<uint64_t, uint64_t>>& ranges) {
+        std::ostringstream ss;
+        if (ranges.empty()) {
+            ss << "(none)";
+        }
+        for (const auto& [begin, end] : ranges) {
+            ss << "[" << begin << "," << end << ")";
+        }
+        return ss.str();
+    }
+
+    std::string description() const override { return "pending ranges: " + to_string(ranges_); }
+
+    void execute(Reassembler& r) const override {
+        const auto actual = r.pending_ranges();
+        if (actual != ranges_) {
+            throw ExpectationViolation("Reassembler reported pending ranges " + to_string(actual));
+        }
+    }
+};
+
 struct Insert : public Action<Reassembler> {
     std::string data_;
     uint64_t first_index_;
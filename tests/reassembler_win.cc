@@ -18,9 +18,10 @@ int main() {
     try {
         auto rd = get_random_engine();
 
-        // overlapping segments
-        for (unsigned rep_no = 0; rep_no < NREPS; ++rep_no) {
-            ReassemblerTestHarness sr {"win test " + to_string(rep_no), NSEGS * MAX_SEG_LEN};
+        // overlapping segments, with both storage engines
+        for (unsigned rep_no = 0; rep_no < 2 * NREPS; ++rep_no) {
+            const auto storage = rep_no < NREPS ? Reassembler::Storage::IntervalMap : Reassembler::Storage::Bitmap;
+            ReassemblerTestHarness sr {"win test " + to_string(rep_no), NSEGS * MAX_SEG_LEN, storage};
 
             vector<tuple<size_t, size_t>> seq_size;
             size_t offset = 0;
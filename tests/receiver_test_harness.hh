@@ -8,6 +8,7 @@
 #include <optional>
 #include <sstream>
 #include <utility>
+#include <vector>
 
 template<std::derived_from<TestStep<Reassembler>> T>
 struct DirectReassemblerTest : public TestStep<TCPReceiver> {
@@ -59,6 +60,18 @@ struct ExpectWindow : public ExpectNumber<TCPReceiver, uint16_t> {
     uint16_t value(TCPReceiver& rs) const override { return rs.send().window_size; }
 };
 
+struct ExpectWindowScale : public ExpectNumber<TCPReceiver, std::optional<uint8_t>> {
+    using ExpectNumber::ExpectNumber;
+    std::string name() const override { return "window_scale"; }
+    std::optional<uint8_t> value(TCPReceiver& rs) const override { return rs.send().window_scale; }
+};
+
+struct ExpectMaxSegmentSize : public ExpectNumber<TCPReceiver, std::optional<uint16_t>> {
+    using ExpectNumber::ExpectNumber;
+    std::string name() const override { return "max_segment_size"; }
+    std::optional<uint16_t> value(TCPReceiver& rs) const override { return rs.send().max_segment_size; }
+};
+
 struct ExpectAckno : public ExpectNumber<TCPReceiver, std::optional<Wrap32>> {
     using ExpectNumber::ExpectNumber;
     std::string name() const override { return "ackno"; }
@@ -96,12 +109,74 @@ struct ExpectAcknoBetween : public Expectation<TCPReceiver> {
     }
 };
 
+struct ExpectSACKBlocks : public Expectation<TCPReceiver> {
+    std::vector<std::pair<Wrap32, Wrap32>> blocks_;
+    explicit ExpectSACKBlocks(std::vector<std::pair<Wrap32, Wrap32>> blocks) : blocks_(std::move(blocks)) {}
+
+    std::string description() const override {
+        std::ostringstream ss;
+        ss << "SACK blocks:";
+        if (blocks_.empty()) {
+            ss << " (none)";
+        }
+        for (const auto& [left, right] : blocks_) {
+            ss << " [" << left << "," << right << ")";
+        }
+        return ss.str();
+    }
+
+    void execute(TCPReceiver& rs) const override {
+        const auto msg = rs.send();
+        std::vector<std::pair<Wrap32, Wrap32>> actual;
+        for (const auto& block : msg.sack_blocks) {
+            actual.emplace_back(block.left, block.right);
+        }
+        if (actual != blocks_) {
+            std::ostringstream ss;
+            ss << "TCPReceiver reported " << actual.size() << " SACK blocks:";
+            for (const auto& [left, right] : actual) {
+                ss << " [" << left << "," << right << ")";
+            }
+            throw ExpectationViolation(ss.str());
+        }
+    }
+};
+
 struct HasAckno : public ExpectBool<TCPReceiver> {
     using ExpectBool::ExpectBool;
     std::string name() const override { return "ackno.has_value()"; }
     bool value(TCPReceiver& rs) const override { return rs.send().ackno.has_value(); }
 };
 
+struct ExpectCapacity : public ExpectNumber<TCPReceiver, uint64_t> {
+    using ExpectNumber::ExpectNumber;
+    std::string name() const override { return "capacity"; }
+    uint64_t value(TCPReceiver& rs) const override { return rs.capacity(); }
+};
+
+struct EnableAutotuning : public Action<TCPReceiver> {
+    uint64_t max_capacity_;
+    MemoryBudget* budget_;
+
+    explicit EnableAutotuning(uint64_t max_capacity, MemoryBudget* budget = nullptr)
+      : max_capacity_(max_capacity), budget_(budget) {}
+    EnableAutotuning(const EnableAutotuning& other) = default;
+    EnableAutotuning& operator=(const EnableAutotuning& other) = default;
+    std::string description() const override {
+        return "autotune up to " + std::to_string(max_capacity_) + " bytes"
+               + (budget_ ? " within a budget of " + std::to_string(budget_->limit()) : "");
+    }
+    void execute(TCPReceiver& rs) const override { rs.enable_autotuning(max_capacity_, budget_); }
+};
+
+struct Tick : public Action<TCPReceiver> {
+    uint64_t ms_;
+
+    explicit Tick(uint64_t ms) : ms_(ms) {}
+    std::string description() const override { return std::to_string(ms_) + " ms pass"; }
+    void execute(TCPReceiver& rs) const override { rs.tick(ms_); }
+};
+
 struct SegmentArrives : public Action<TCPReceiver> {
     TCPSenderMessage msg_ {};
     HasAckno ackno_expected_ {true};
@@ -116,6 +191,11 @@ struct SegmentArrives : public Action<TCPReceiver> {
         return *this;
     }
 
+    SegmentArrives& with_sack_permitted() {
+        msg_.SACK_permitted = true;
+        return *this;
+    }
+
     SegmentArrives& with_rst() {
         msg_.RST = true;
         return *this;
@@ -90,26 +90,37 @@ int main() {
         {
             TCPReceiverTestHarness test {"window size 50", 50};
             test.execute(ExpectWindow {50});
+            test.execute(ExpectMaxSegmentSize {TCPConfig::MAX_PAYLOAD_SIZE});
         }
 
         {
             TCPReceiverTestHarness test {"window size at max", UINT16_MAX};
             test.execute(ExpectWindow {UINT16_MAX});
+            test.execute(ExpectWindowScale {0});
         }
 
         {
             TCPReceiverTestHarness test {"window size at max+1", UINT16_MAX + 1};
-            test.execute(ExpectWindow {UINT16_MAX});
+            test.execute(ExpectWindow {(UINT16_MAX + 1) / 2});
+            test.execute(ExpectWindowScale {1});
         }
 
         {
             TCPReceiverTestHarness test {"window size at max+5", UINT16_MAX + 5};
-            test.execute(ExpectWindow {UINT16_MAX});
+            test.execute(ExpectWindow {(UINT16_MAX + 5) / 2});
+            test.execute(ExpectWindowScale {1});
         }
 
         {
             TCPReceiverTestHarness test {"window size at 10M", 10'000'000};
+            test.execute(ExpectWindow {10'000'000 >> 8});
+            test.execute(ExpectWindowScale {8});
+        }
+
+        {
+            TCPReceiverTestHarness test {"window size at 4G", 4'000'000'000};
             test.execute(ExpectWindow {UINT16_MAX});
+            test.execute(ExpectWindowScale {TCPReceiverMessage::MAX_WINDOW_SCALE});
         }
     } catch (const exception& e) {
         cerr << e.what() << endl;
@@ -0,0 +1,77 @@
+#include "random.hh"
+#include "receiver_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_engine();
+
+        {
+            const uint32_t isn = uniform_int_distribution<uint32_t> {0, UINT32_MAX}(rd);
+            TCPReceiverTestHarness test {"no SACK blocks unless the SYN permits them", 4000};
+            test.execute(SegmentArrives {}.with_syn().with_seqno(isn));
+            test.execute(SegmentArrives {}.with_seqno(isn + 5).with_data("efgh"));
+            test.execute(ExpectAckno {Wrap32 {isn + 1}});
+            test.execute(BytesPending {4});
+            test.execute(ExpectSACKBlocks {{}});
+        }
+
+        {
+            const uint32_t isn = uniform_int_distribution<uint32_t> {0, UINT32_MAX}(rd);
+            TCPReceiverTestHarness test {"SACK blocks report the data above a hole", 4000};
+            test.execute(SegmentArrives {}.with_syn().with_sack_permitted().with_seqno(isn));
+            test.execute(ExpectSACKBlocks {{}});
+            test.execute(SegmentArrives {}.with_seqno(isn + 1).with_data("ab"));
+            test.execute(ExpectSACKBlocks {{}});
+
+            test.execute(SegmentArrives {}.with_seqno(isn + 5).with_data("ef"));
+            test.execute(ExpectAckno {Wrap32 {isn + 3}});
+            test.execute(ExpectSACKBlocks {{{Wrap32 {isn + 5}, Wrap32 {isn + 7}}}});
+
+            /* the block holding the latest segment comes first */
+            test.execute(SegmentArrives {}.with_seqno(isn + 9).with_data("ij"));
+            test.execute(
+              ExpectSACKBlocks {{{Wrap32 {isn + 9}, Wrap32 {isn + 11}}, {Wrap32 {isn + 5}, Wrap32 {isn + 7}}}});
+            test.execute(SegmentArrives {}.with_seqno(isn + 5).with_data("ef"));
+            test.execute(
+              ExpectSACKBlocks {{{Wrap32 {isn + 5}, Wrap32 {isn + 7}}, {Wrap32 {isn + 9}, Wrap32 {isn + 11}}}});
+
+            /* filling the gap between blocks merges them */
+            test.execute(SegmentArrives {}.with_seqno(isn + 7).with_data("gh"));
+            test.execute(ExpectSACKBlocks {{{Wrap32 {isn + 5}, Wrap32 {isn + 11}}}});
+
+            /* filling the hole leaves nothing to report */
+            test.execute(SegmentArrives {}.with_seqno(isn + 3).with_data("cd"));
+            test.execute(ExpectAckno {Wrap32 {isn + 11}});
+            test.execute(ExpectSACKBlocks {{}});
+            test.execute(ReadAll {"abcdefghij"});
+        }
+
+        {
+            const uint32_t isn = uniform_int_distribution<uint32_t> {0, UINT32_MAX}(rd);
+            TCPReceiverTestHarness test {"at most four SACK blocks, the rest from the highest down", 4000};
+            test.execute(SegmentArrives {}.with_syn().with_sack_permitted().with_seqno(isn));
+            for (uint32_t i = 1; i <= 6; ++i) {
+                test.execute(SegmentArrives {}.with_seqno(isn + 1 + 10 * i).with_data("x"));
+            }
+            test.execute(SegmentArrives {}.with_seqno(isn + 31).with_data("x"));
+            test.execute(BytesPending {6});
+            test.execute(ExpectSACKBlocks {{{Wrap32 {isn + 31}, Wrap32 {isn + 32}},
+                                            {Wrap32 {isn + 61}, Wrap32 {isn + 62}},
+                                            {Wrap32 {isn + 51}, Wrap32 {isn + 52}},
+                                            {Wrap32 {isn + 41}, Wrap32 {isn + 42}}}});
+        }
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -104,6 +104,60 @@ int main() {
             test.execute(BytesPending(0));
         }
 
+        {
+            const uint32_t isn = 23452;
+            TCPReceiverTestHarness test {"autotuning grows the window to twice what is read per RTT", 4000};
+            test.execute(EnableAutotuning {20000});
+            test.execute(SegmentArrives {}.with_syn().with_seqno(isn));
+            test.execute(ExpectWindow {4000});
+
+            /* the sender takes 10 ms to fill the window: that is the RTT */
+            test.execute(Tick {10});
+            test.execute(SegmentArrives {}.with_seqno(isn + 1).with_data(string(4000, 'x')));
+            test.execute(ExpectWindow {0});
+            test.execute(ReadAll {string(4000, 'x')});
+            test.execute(ExpectCapacity {4000});
+            test.execute(Tick {5});
+            test.execute(ExpectCapacity {8000});
+            test.execute(ExpectWindow {8000});
+
+            /* reading faster raises it again, up to the limit */
+            test.execute(SegmentArrives {}.with_seqno(isn + 4001).with_data(string(8000, 'x')));
+            test.execute(ReadAll {string(8000, 'x')});
+            test.execute(Tick {10});
+            test.execute(ExpectCapacity {16000});
+            test.execute(SegmentArrives {}.with_seqno(isn + 12001).with_data(string(16000, 'x')));
+            test.execute(ReadAll {string(16000, 'x')});
+            test.execute(Tick {10});
+            test.execute(ExpectCapacity {20000});
+            test.execute(ExpectWindow {20000});
+        }
+
+        {
+            const uint32_t isn = 23452;
+            MemoryBudget budget {3000};
+            TCPReceiverTestHarness test {"autotuning stays within the memory budget", 4000};
+            test.execute(EnableAutotuning {20000, &budget});
+            test.execute(SegmentArrives {}.with_syn().with_seqno(isn));
+            test.execute(Tick {10});
+            test.execute(SegmentArrives {}.with_seqno(isn + 1).with_data(string(4000, 'x')));
+            test.execute(ReadAll {string(4000, 'x')});
+            test.execute(Tick {10});
+            test.execute(ExpectCapacity {4000});
+            test.execute(ExpectWindow {4000});
+        }
+
+        {
+            const uint32_t isn = 23452;
+            TCPReceiverTestHarness test {"without autotuning the capacity stays put", 4000};
+            test.execute(SegmentArrives {}.with_syn().with_seqno(isn));
+            test.execute(Tick {10});
+            test.execute(SegmentArrives {}.with_seqno(isn + 1).with_data(string(4000, 'x')));
+            test.execute(ReadAll {string(4000, 'x')});
+            test.execute(Tick {10});
+            test.execute(ExpectCapacity {4000});
+        }
+
     } catch (const exception& e) {
         cerr << e.what() << endl;
         return 1;
@@ -0,0 +1,180 @@
+#include "arp_message.hh"
+#include "forwarding_table_common.hh"
+#include "router.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+void speed_test(const size_t num_prefixes, // NOLINT(bugprone-easily-swappable-parameters)
+                const size_t num_lookups,  // NOLINT(bugprone-easily-swappable-parameters)
+                const size_t random_seed)
+{
+    default_random_engine rd {random_seed};
+    const auto prefixes = random_prefixes(rd, num_prefixes);
+
+    vector<uint32_t> addresses(1 << 20);
+    for (auto& address : addresses) {
+        address = rd();
+    }
+
+    ForwardingTable table;
+    const auto load_start = steady_clock::now();
+    for (size_t i = 0; i < prefixes.size(); ++i) {
+        table.add(get<0>(prefixes[i]), get<1>(prefixes[i]), i);
+    }
+    const auto load_stop = steady_clock::now();
+
+    size_t matched = 0;
+    const auto start_time = steady_clock::now();
+    for (size_t i = 0; i < num_lookups; ++i) {
+        matched += table.lookup(addresses[i % addresses.size()]).has_value();
+    }
+    const auto stop_time = steady_clock::now();
+
+    const auto load_duration = duration_cast<duration<double>>(load_stop - load_start);
+    const auto test_duration = duration_cast<duration<double>>(stop_time - start_time);
+    const auto lookups_per_second = static_cast<double>(num_lookups) / test_duration.count();
+    const auto megabytes = static_cast<double>(table.memory_usage()) / 1e6;
+
+    fstream debug_output;
+    debug_output.open("/dev/tty");
+
+    cout << "ForwardingTable with " << num_prefixes << " prefixes (loaded in " << fixed << setprecision(2)
+         << load_duration.count() << " s, " << megabytes << " MB) reached " << lookups_per_second / 1e6
+         << " million lookups/s (" << 100.0 * static_cast<double>(matched) / static_cast<double>(num_lookups)
+         << "% matched).\n";
+
+    debug_output << "           Forwarding lookup rate: " << fixed << setprecision(2) << lookups_per_second / 1e6
+                 << " million/s\n";
+
+    if (lookups_per_second < 1e6) {
+        throw runtime_error("ForwardingTable did not meet minimum speed of 1 million lookups/s.");
+    }
+}
+
+// An output port that answers the first ARP request, then just counts frames
+class CountingPort : public NetworkInterface::OutputPort {
+  public:
+    size_t frames {};
+    size_t bytes {};
+    std::optional<ARPMessage> arp_request {};
+
+    void transmit(const NetworkInterface& sender [[maybe_unused]], const EthernetFrame& frame) override {
+        if (frame.header.type == EthernetHeader::TYPE_ARP) {
+            ARPMessage arp;
+            if (parse(arp, frame.payload)) {
+                arp_request = arp;
+            }
+            return;
+        }
+        ++frames;
+        for (const auto& buf : frame.payload) {
+            bytes += buf.size();
+        }
+    }
+};
+
+void forwarding_speed_test(const size_t num_datagrams, // NOLINT(bugprone-easily-swappable-parameters)
+                           const size_t payload_size,  // NOLINT(bugprone-easily-swappable-parameters)
+                           const size_t batch_size)
+{
+    const EthernetAddress router_eth {0x02, 0, 0, 0, 0, 1};
+    const EthernetAddress next_hop_eth {0x02, 0, 0, 0, 0, 2};
+
+    auto in_port = make_shared<CountingPort>();
+    auto out_port = make_shared<CountingPort>();
+    Router router;
+    router.add_interface(make_shared<NetworkInterface>("in", in_port, router_eth, Address {"10.0.0.1"}));
+    router.add_interface(make_shared<NetworkInterface>("out", out_port, router_eth, Address {"10.1.0.1"}));
+    router.add_route(Address {"10.1.0.0"}.ipv4_numeric(), 16, Address {"10.1.0.2"}, 1);
+
+    const uint32_t src = Address {"10.0.0.2"}.ipv4_numeric();
+    const uint32_t dst = Address {"10.1.2.3"}.ipv4_numeric();
+    auto make_datagram = [&] {
+        InternetDatagram dgram;
+        dgram.header.src = src;
+        dgram.header.dst = dst;
+        dgram.header.len = IPv4Header::LENGTH + payload_size;
+        dgram.header.compute_checksum();
+        dgram.payload.emplace_back(payload_size, 'x');
+        return dgram;
+    };
+
+    // First datagram triggers ARP; answer it so the rest go straight out
+    router.interface(0)->datagrams_received().push(make_datagram());
+    router.route();
+    if (not out_port->arp_request.has_value()) {
+        throw runtime_error("Router did not ARP for the next hop");
+    }
+    ARPMessage reply;
+    reply.opcode = ARPMessage::OPCODE_REPLY;
+    reply.sender_ethernet_address = next_hop_eth;
+    reply.sender_ip_address = out_port->arp_request->target_ip_address;
+    reply.target_ethernet_address = router_eth;
+    reply.target_ip_address = out_port->arp_request->sender_ip_address;
+    router.interface(1)->recv_frame({{router_eth, next_hop_eth, EthernetHeader::TYPE_ARP}, serialize(reply)});
+    out_port->frames = out_port->bytes = 0;
+
+    // Datagrams are built ahead of time; only the route() calls are timed
+    vector<InternetDatagram> batch;
+    duration<double> test_duration {};
+    for (size_t sent = 0; sent < num_datagrams; sent += batch_size) {
+        batch.clear();
+        for (size_t i = 0; i < batch_size; ++i) {
+            batch.push_back(make_datagram());
+        }
+
+        const auto start_time = steady_clock::now();
+        auto& queue = router.interface(0)->datagrams_received();
+        for (auto& dgram : batch) {
+            queue.push(move(dgram));
+        }
+        router.route();
+        test_duration += steady_clock::now() - start_time;
+    }
+
+    if (out_port->frames != num_datagrams
+        or out_port->bytes != num_datagrams * (IPv4Header::LENGTH + payload_size)) {
+        throw runtime_error("Router did not forward every datagram");
+    }
+
+    const auto packets_per_second = static_cast<double>(num_datagrams) / test_duration.count();
+
+    fstream debug_output;
+    debug_output.open("/dev/tty");
+
+    cout << "Router forwarding " << payload_size << "-byte payloads reached " << fixed << setprecision(2)
+         << packets_per_second / 1e6 << " million packets/s.\n";
+
+    debug_output << "              Router forwarding rate: " << fixed << setprecision(2) << packets_per_second / 1e6
+                 << " Mpps\n";
+
+    if (packets_per_second < 1e5) {
+        throw runtime_error("Router did not meet minimum speed of 100k packets/s.");
+    }
+}
+
+void program_body() {
+    speed_test(500000, 5e7, 1492);
+    forwarding_speed_test(1000000, 1480, 1000);
+}
+
+int main() {
+    try {
+        program_body();
+    } catch (const exception& e) {
+        cerr << "Exception: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
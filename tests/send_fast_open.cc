@@ -0,0 +1,169 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_engine();
+
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+
+            TCPSenderTestHarness test {"without Fast Open, the SYN carries no cookie option", cfg};
+            test.execute(Push {});
+            test.execute(ExpectMessage {}.with_syn(true).with_payload_size(0).with_fast_open_cookie({}));
+        }
+
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+
+            TCPSenderTestHarness test {"without a cookie, the SYN requests one and the data waits", cfg};
+            test.execute(EnableFastOpen {});
+            test.execute(Push {"hello"});
+            test.execute(ExpectMessage {}
+                           .with_no_flags()
+                           .with_syn(true)
+                           .with_payload_size(0)
+                           .with_seqno(isn)
+                           .with_fast_open_cookie(""));
+            test.execute(ExpectNoSegment {});
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(1000));
+            test.execute(
+              ExpectMessage {}.with_no_flags().with_data("hello").with_seqno(isn + 1).with_fast_open_cookie({}));
+            test.execute(ExpectNoSegment {});
+        }
+
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+
+            TCPSenderTestHarness test {"with a cookie, the data rides on the SYN", cfg};
+            test.execute(EnableFastOpen {"cookie!!"});
+            test.execute(Push {"hello"});
+            test.execute(ExpectMessage {}
+                           .with_no_flags()
+                           .with_syn(true)
+                           .with_data("hello")
+                           .with_seqno(isn)
+                           .with_fast_open_cookie("cookie!!"));
+            test.execute(ExpectSeqnosInFlight {6});
+            test.execute(AckReceived {Wrap32 {isn + 6}}.with_win(1000));
+            test.execute(ExpectSeqnosInFlight {0});
+            test.execute(ExpectNoSegment {});
+
+            /* later segments carry no cookie */
+            test.execute(Push {"world"});
+            test.execute(ExpectMessage {}.with_data("world").with_seqno(isn + 6).with_fast_open_cookie({}));
+        }
+
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+
+            TCPSenderTestHarness test {"data the server refused is resent at once", cfg};
+            test.execute(EnableFastOpen {"stale cookie"});
+            test.execute(Push {"hello"});
+            test.execute(ExpectMessage {}.with_syn(true).with_data("hello").with_seqno(isn));
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(1000));
+            test.execute(
+              ExpectMessage {}.with_no_flags().with_data("hello").with_seqno(isn + 1).with_fast_open_cookie({}));
+            test.execute(ExpectNoSegment {});
+            test.execute(ExpectSeqnosInFlight {5});
+            test.execute(ExpectConsecutiveRetransmissions {0});
+            test.execute(AckReceived {Wrap32 {isn + 6}}.with_win(1000));
+            test.execute(ExpectSeqnosInFlight {0});
+        }
+
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+
+            TCPSenderTestHarness test {"a refused FIN is resent with the data", cfg};
+            test.execute(EnableFastOpen {"stale cookie"});
+            test.execute(Push {"hello"}.with_close());
+            test.execute(ExpectMessage {}.with_syn(true).with_fin(true).with_data("hello").with_seqno(isn));
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(1000));
+            test.execute(ExpectMessage {}.with_no_flags().with_fin(true).with_data("hello").with_seqno(isn + 1));
+            test.execute(ExpectNoSegment {});
+            test.execute(AckReceived {Wrap32 {isn + 7}}.with_win(1000));
+            test.execute(ExpectSeqnosInFlight {0});
+        }
+
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+
+            TCPSenderTestHarness test {"without Fast Open, a SYN+FIN acknowledged in part is not split", cfg};
+            test.execute(Push {}.with_close());
+            test.execute(ExpectMessage {}.with_syn(true).with_fin(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(1000));
+            test.execute(ExpectSeqnosInFlight {2});
+            test.execute(ExpectNoSegment {});
+            test.execute(AckReceived {Wrap32 {isn + 2}}.with_win(1000));
+            test.execute(ExpectSeqnosInFlight {0});
+        }
+
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+
+            TCPSenderTestHarness test {"a Fast Open SYN+FIN without data is not split", cfg};
+            test.execute(EnableFastOpen {"cookie!!"});
+            test.execute(Push {}.with_close());
+            test.execute(ExpectMessage {}.with_syn(true).with_fin(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(1000));
+            test.execute(ExpectSeqnosInFlight {2});
+            test.execute(ExpectNoSegment {});
+        }
+
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+
+            TCPSenderTestHarness test {"a Fast Open server sends within the window of the peer's SYN", cfg};
+            test.execute(EnableFastOpen {});
+            test.execute(Receive {TCPReceiverMessage {}}.with_win(1000));
+            test.execute(ExpectMessage {}.with_syn(true).with_payload_size(0).with_fast_open_cookie({}));
+            test.execute(Push {"response"});
+            test.execute(ExpectMessage {}.with_no_flags().with_data("response").with_seqno(isn + 1));
+            test.execute(ExpectNoSegment {});
+        }
+
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+
+            TCPSenderTestHarness test {"without Fast Open, a server waits for the ACK of its SYN", cfg};
+            test.execute(Receive {TCPReceiverMessage {}}.with_win(1000));
+            test.execute(ExpectMessage {}.with_syn(true).with_payload_size(0));
+            test.execute(Push {"response"});
+            test.execute(ExpectNoSegment {});
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(1000));
+            test.execute(ExpectMessage {}.with_no_flags().with_data("response").with_seqno(isn + 1));
+        }
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
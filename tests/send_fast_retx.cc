@@ -0,0 +1,160 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_engine();
+        constexpr uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+
+            TCPSenderTestHarness test {
+                "Slow start grows by the bytes acked, up to two segments per ACK", cfg, CongestionControl::Reno};
+            test.execute(Push {});
+            test.execute(ExpectMessage {}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(60000));
+            test.execute(ExpectCongestionWindow {10 * mss + 1});
+            test.execute(Push {string(5 * mss, 'x')});
+            for (uint64_t i = 0; i < 5; ++i) {
+                test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(isn + 1 + i * mss));
+            }
+
+            /* a delayed ACK of two segments counts for both */
+            test.execute(AckReceived {Wrap32 {isn + 1 + 2 * mss}}.with_win(60000));
+            test.execute(ExpectCongestionWindow {12 * mss + 1});
+            test.execute(AckReceived {Wrap32 {isn + 1 + 5 * mss}}.with_win(60000));
+            test.execute(ExpectCongestionWindow {14 * mss + 1});
+        }
+
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+
+            TCPSenderTestHarness test {
+                "Three duplicate ACKs trigger a retransmission", cfg, CongestionControl::Reno};
+            test.execute(Push {});
+            test.execute(ExpectMessage {}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(60000));
+            test.execute(Push {string(4 * mss, 'x')});
+            for (uint64_t i = 0; i < 4; ++i) {
+                test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(isn + 1 + i * mss));
+            }
+            test.execute(ExpectNoSegment {});
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(60000));
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(60000));
+            test.execute(ExpectNoSegment {});
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(60000));
+            test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment {});
+            test.execute(ExpectCongestionWindow {2 * mss});
+            test.execute(ExpectConsecutiveRetransmissions {0});
+        }
+
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+
+            TCPSenderTestHarness test {
+                "Duplicate ACKs with nothing outstanding are ignored", cfg, CongestionControl::Reno};
+            test.execute(Push {});
+            test.execute(ExpectMessage {}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(60000));
+            test.execute(Push {"abc"});
+            test.execute(ExpectMessage {}.with_payload_size(3).with_data("abc").with_seqno(isn + 1));
+            test.execute(AckReceived {Wrap32 {isn + 4}}.with_win(60000));
+            for (int i = 0; i < 4; ++i) {
+                test.execute(AckReceived {Wrap32 {isn + 4}}.with_win(60000));
+            }
+            test.execute(ExpectNoSegment {});
+            test.execute(ExpectCongestionWindow {10 * mss + 4});
+        }
+
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+
+            TCPSenderTestHarness test {"Partial ACKs resend the next hole", cfg, CongestionControl::Reno};
+            test.execute(Push {});
+            test.execute(ExpectMessage {}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(60000));
+            test.execute(Push {string(6 * mss, 'x')});
+            for (uint64_t i = 0; i < 6; ++i) {
+                test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(isn + 1 + i * mss));
+            }
+
+            /* the first and third segments were lost */
+            for (int i = 0; i < 3; ++i) {
+                test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(60000));
+            }
+            test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(isn + 1));
+            test.execute(ExpectCongestionWindow {3 * mss});
+            test.execute(AckReceived {Wrap32 {isn + 1 + 2 * mss}}.with_win(60000));
+            test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(isn + 1 + 2 * mss));
+            test.execute(ExpectNoSegment {});
+
+            /* a full ACK ends recovery without growing the window */
+            test.execute(AckReceived {Wrap32 {isn + 1 + 6 * mss}}.with_win(60000));
+            test.execute(ExpectNoSegment {});
+            test.execute(ExpectSeqnosInFlight {0});
+            test.execute(ExpectCongestionWindow {3 * mss});
+
+            /* after which the window grows by one segment per window acked */
+            test.execute(Push {string(3 * mss, 'x')});
+            for (uint64_t i = 6; i < 9; ++i) {
+                test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(isn + 1 + i * mss));
+            }
+            test.execute(AckReceived {Wrap32 {isn + 1 + 9 * mss}}.with_win(60000));
+            test.execute(ExpectCongestionWindow {4 * mss});
+        }
+
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+
+            TCPSenderTestHarness test {
+                "Losses in a recovered window are not counted twice", cfg, CongestionControl::Reno};
+            test.execute(Push {});
+            test.execute(ExpectMessage {}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(60000));
+            test.execute(Push {string(8 * mss, 'x')});
+            for (uint64_t i = 0; i < 8; ++i) {
+                test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(isn + 1 + i * mss));
+            }
+            for (int i = 0; i < 3; ++i) {
+                test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(60000));
+            }
+            test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(isn + 1));
+            test.execute(ExpectCongestionWindow {4 * mss});
+
+            /* a timeout ends recovery; duplicate ACKs for data sent before it are old news */
+            test.execute(Tick {cfg.rt_timeout});
+            test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(isn + 1));
+            test.execute(ExpectCongestionWindow {mss});
+            for (int i = 0; i < 3; ++i) {
+                test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(60000));
+            }
+            test.execute(ExpectNoSegment {});
+            test.execute(ExpectCongestionWindow {mss});
+        }
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
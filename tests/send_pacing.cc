@@ -0,0 +1,123 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_engine();
+        constexpr uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+            const auto seg = [&](uint64_t i) { return isn + 1 + static_cast<uint32_t>(i * mss); };
+
+            TCPSenderTestHarness test {"a fixed rate spreads the window over ticks", cfg};
+            test.execute(EnablePacing {mss / 2.0});
+            test.execute(Push {});
+            test.execute(ExpectMessage {}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(10 * mss));
+
+            /* the bucket starts with two segments' worth */
+            test.execute(Push {string(5 * mss, 'x')});
+            test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(seg(0)));
+            test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(seg(1)));
+            test.execute(ExpectNoSegment {});
+
+            /* then one segment every other millisecond */
+            test.execute(Tick {1});
+            test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(seg(2)));
+            test.execute(Tick {1});
+            test.execute(ExpectNoSegment {});
+            test.execute(Tick {1});
+            test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(seg(3)));
+            test.execute(ExpectNoSegment {});
+            test.execute(Tick {2});
+            test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(seg(4)));
+            test.execute(ExpectNoSegment {});
+
+            /* a coarse tick releases what the rate allowed over all of it */
+            test.execute(AckReceived {seg(5)}.with_win(10 * mss));
+            test.execute(Push {string(6 * mss, 'x')});
+            test.execute(ExpectNoSegment {});
+            test.execute(Tick {10});
+            for (uint64_t i = 5; i < 10; ++i) {
+                test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(seg(i)));
+            }
+            test.execute(ExpectNoSegment {});
+            test.execute(Tick {10});
+            test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(seg(10)));
+            test.execute(ExpectNoSegment {});
+        }
+
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+
+            TCPSenderTestHarness test {"an idle sender saves up only a small burst", cfg};
+            test.execute(EnablePacing {mss / 2.0});
+            test.execute(Push {});
+            test.execute(ExpectMessage {}.with_syn(true).with_seqno(isn));
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(10 * mss));
+            test.execute(Tick {1000});
+            test.execute(Push {string(5 * mss, 'x')});
+            test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(isn + 1));
+            test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(isn + 1 + mss));
+            test.execute(ExpectNoSegment {});
+        }
+
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+
+            TCPSenderTestHarness test {"the retransmission timer keeps running under the pace", cfg};
+            test.execute(EnablePacing {1.0});
+            test.execute(Push {});
+            test.execute(ExpectMessage {}.with_syn(true).with_seqno(isn));
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(10 * mss));
+            test.execute(Push {string(3 * mss, 'x')});
+            test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(isn + 1));
+            test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(isn + 1 + mss));
+            test.execute(ExpectNoSegment {});
+            test.execute(Tick {cfg.rt_timeout - 1UL});
+            test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(isn + 1 + 2 * mss));
+            test.execute(ExpectNoSegment {});
+            test.execute(Tick {1});
+            test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment {});
+        }
+
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+
+            TCPSenderTestHarness test {"BBR paces without being asked", cfg, CongestionControl::BBR};
+            test.execute(Push {});
+            test.execute(ExpectMessage {}.with_syn(true).with_seqno(isn));
+            test.execute(Tick {10});
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(10 * mss));
+
+            /* the handshake measured a rate, so BBR holds the window back to two segments' worth of tokens */
+            test.execute(Push {string(5 * mss, 'x')});
+            test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(isn + 1));
+            test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(isn + 1 + mss));
+            test.execute(ExpectNoSegment {});
+        }
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
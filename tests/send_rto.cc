@@ -0,0 +1,168 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_engine();
+
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+            cfg.rt_timeout = 1000;
+
+            TCPSenderTestHarness test {"RTO follows the RTT samples", cfg, {1, 60000}};
+            test.execute(ExpectRTO {1000});
+            test.execute(ExpectSRTT {0});
+            test.execute(Push {});
+            test.execute(ExpectMessage {}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick {100});
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(1000));
+            test.execute(ExpectSRTT {100});
+            test.execute(ExpectRTTVAR {50});
+            test.execute(ExpectRTO {300});
+            test.execute(Push {"abc"});
+            test.execute(ExpectMessage {}.with_payload_size(3).with_data("abc").with_seqno(isn + 1));
+            test.execute(Tick {60});
+            test.execute(AckReceived {Wrap32 {isn + 4}}.with_win(1000));
+            test.execute(ExpectSRTT {95});
+            test.execute(ExpectRTTVAR {47.5});
+            test.execute(ExpectRTO {285});
+            test.execute(Push {"def"});
+            test.execute(ExpectMessage {}.with_payload_size(3).with_data("def").with_seqno(isn + 4));
+            test.execute(Tick {284});
+            test.execute(ExpectNoSegment {});
+            test.execute(Tick {1});
+            test.execute(ExpectMessage {}.with_payload_size(3).with_data("def").with_seqno(isn + 4));
+        }
+
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+            cfg.rt_timeout = 1000;
+
+            TCPSenderTestHarness test {"Retransmitted segments give no RTT sample", cfg, {1, 60000}};
+            test.execute(Push {});
+            test.execute(ExpectMessage {}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick {1000});
+            test.execute(ExpectMessage {}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(ExpectRTO {2000});
+            test.execute(Tick {10});
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(1000));
+            test.execute(ExpectSRTT {0});
+            test.execute(ExpectRTO {2000});
+            test.execute(ExpectConsecutiveRetransmissions {0});
+            test.execute(Push {"abc"});
+            test.execute(ExpectMessage {}.with_payload_size(3).with_data("abc").with_seqno(isn + 1));
+            test.execute(Tick {40});
+            test.execute(AckReceived {Wrap32 {isn + 4}}.with_win(1000));
+            test.execute(ExpectSRTT {40});
+            test.execute(ExpectRTTVAR {20});
+            test.execute(ExpectRTO {120});
+        }
+
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+            cfg.rt_timeout = 1000;
+
+            TCPSenderTestHarness test {"Newest segment acked gives the sample", cfg, {1, 60000}};
+            test.execute(Push {});
+            test.execute(ExpectMessage {}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick {8});
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(1000));
+            test.execute(ExpectSRTT {8});
+            test.execute(Push {"abc"});
+            test.execute(ExpectMessage {}.with_payload_size(3).with_data("abc").with_seqno(isn + 1));
+            test.execute(Tick {4});
+            test.execute(Push {"def"});
+            test.execute(ExpectMessage {}.with_payload_size(3).with_data("def").with_seqno(isn + 4));
+            test.execute(Tick {8});
+            test.execute(AckReceived {Wrap32 {isn + 7}}.with_win(1000));
+            test.execute(ExpectSRTT {8});
+            test.execute(ExpectRTTVAR {3});
+            test.execute(ExpectRTO {20});
+        }
+
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+            cfg.rt_timeout = 1000;
+
+            TCPSenderTestHarness test {"Estimated RTO is clamped to the lower bound", cfg, {200, 60000}};
+            test.execute(Push {});
+            test.execute(ExpectMessage {}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick {2});
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(1000));
+            test.execute(ExpectSRTT {2});
+            test.execute(ExpectRTO {200});
+            test.execute(Push {"abc"});
+            test.execute(ExpectMessage {}.with_payload_size(3).with_data("abc").with_seqno(isn + 1));
+            test.execute(Tick {199});
+            test.execute(ExpectNoSegment {});
+            test.execute(Tick {1});
+            test.execute(ExpectMessage {}.with_payload_size(3).with_data("abc").with_seqno(isn + 1));
+        }
+
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+            cfg.rt_timeout = 100;
+            cfg.rt_timeout_min = 10;
+
+            const TCPSender::RTOBounds bounds {cfg.rt_timeout_min, cfg.rt_timeout_max};
+            TCPSenderTestHarness test {"A small RTT gives a small RTO", cfg, bounds};
+            test.execute(Push {});
+            test.execute(ExpectMessage {}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick {2});
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(1000));
+            test.execute(ExpectSRTT {2});
+            test.execute(ExpectRTO {10});
+            test.execute(Push {"abc"});
+            test.execute(ExpectMessage {}.with_payload_size(3).with_data("abc").with_seqno(isn + 1));
+            test.execute(Tick {9});
+            test.execute(ExpectNoSegment {});
+            test.execute(Tick {1});
+            test.execute(ExpectMessage {}.with_payload_size(3).with_data("abc").with_seqno(isn + 1));
+        }
+
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+            cfg.rt_timeout = 400;
+
+            TCPSenderTestHarness test {"Back-off is clamped to the upper bound", cfg, {1, 500}};
+            test.execute(Push {});
+            test.execute(ExpectMessage {}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick {400});
+            test.execute(ExpectMessage {}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(ExpectRTO {500});
+            test.execute(Tick {499});
+            test.execute(ExpectNoSegment {});
+            test.execute(Tick {1});
+            test.execute(ExpectMessage {}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(ExpectRTO {500});
+            test.execute(ExpectConsecutiveRetransmissions {2});
+        }
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
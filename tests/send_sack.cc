@@ -0,0 +1,161 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_engine();
+        constexpr uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+
+            TCPSenderTestHarness test {"SYN permits SACK", cfg};
+            test.execute(Push {});
+            test.execute(ExpectMessage {}.with_syn(true).with_sack_permitted(true).with_seqno(isn));
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(1000));
+            test.execute(Push {"abc"});
+            test.execute(ExpectMessage {}.with_data("abc").with_sack_permitted(false));
+        }
+
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+            const auto seg = [&](uint64_t i) { return isn + 1 + static_cast<uint32_t>(i * mss); };
+
+            TCPSenderTestHarness test {
+                "SACK blocks resend every hole and nothing else", cfg, CongestionControl::Reno};
+            test.execute(Push {});
+            test.execute(ExpectMessage {}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(60000));
+            test.execute(Push {string(8 * mss, 'x')});
+            for (uint64_t i = 0; i < 8; ++i) {
+                test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(seg(i)));
+            }
+
+            /* the first and third segments were lost */
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(60000).with_sack(seg(1), seg(2)));
+            test.execute(
+              AckReceived {Wrap32 {isn + 1}}.with_win(60000).with_sack(seg(3), seg(4)).with_sack(seg(1), seg(2)));
+            test.execute(ExpectNoSegment {});
+            test.execute(
+              AckReceived {Wrap32 {isn + 1}}.with_win(60000).with_sack(seg(3), seg(5)).with_sack(seg(1), seg(2)));
+            test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(seg(0)));
+            test.execute(ExpectNoSegment {});
+            test.execute(ExpectCongestionWindow {4 * mss});
+
+            /* three SACKed segments above the second hole: it is lost too, without waiting for a partial ACK */
+            test.execute(
+              AckReceived {Wrap32 {isn + 1}}.with_win(60000).with_sack(seg(3), seg(6)).with_sack(seg(1), seg(2)));
+            test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(seg(2)));
+            test.execute(ExpectNoSegment {});
+
+            /* the partial ACK does not resend the hole again */
+            test.execute(AckReceived {seg(2)}.with_win(60000).with_sack(seg(3), seg(8)));
+            test.execute(ExpectNoSegment {});
+            test.execute(AckReceived {seg(8)}.with_win(60000));
+            test.execute(ExpectSeqnosInFlight {0});
+            test.execute(ExpectCongestionWindow {4 * mss});
+        }
+
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+            const auto seg = [&](uint64_t i) { return isn + 1 + static_cast<uint32_t>(i * mss); };
+
+            TCPSenderTestHarness test {
+                "SACKed segments are not resent after a timeout", cfg, CongestionControl::Reno};
+            test.execute(Push {});
+            test.execute(ExpectMessage {}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(60000));
+            test.execute(Push {string(4 * mss, 'x')});
+            for (uint64_t i = 0; i < 4; ++i) {
+                test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(seg(i)));
+            }
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(60000).with_sack(seg(1), seg(2)));
+            test.execute(
+              AckReceived {Wrap32 {isn + 1}}.with_win(60000).with_sack(seg(3), seg(4)).with_sack(seg(1), seg(2)));
+            test.execute(ExpectNoSegment {});
+
+            test.execute(Tick {cfg.rt_timeout});
+            test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(seg(0)));
+            test.execute(ExpectNoSegment {});
+            test.execute(ExpectCongestionWindow {mss});
+
+            test.execute(AckReceived {seg(1)}.with_win(60000).with_sack(seg(3), seg(4)));
+            test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(seg(2)));
+            test.execute(ExpectNoSegment {});
+            test.execute(AckReceived {seg(4)}.with_win(60000));
+            test.execute(ExpectSeqnosInFlight {0});
+        }
+
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+
+            TCPSenderTestHarness test {"SACK blocks outside the window are ignored", cfg, CongestionControl::Reno};
+            test.execute(Push {});
+            test.execute(ExpectMessage {}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(60000));
+            test.execute(Push {string(2 * mss, 'x')});
+            test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(isn + 1));
+            test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(isn + 1 + mss));
+            test.execute(
+              AckReceived {Wrap32 {isn + 1}}.with_win(60000).with_sack(isn + 1 + mss, isn + 1 + 3 * mss));
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(60000).with_sack(isn + 1 + mss, isn + 1));
+            test.execute(ExpectNoSegment {});
+            test.execute(ExpectSeqnosInFlight {2 * mss});
+        }
+
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+            const Wrap32 small = isn + 1 + 2 * mss; // a short segment between two full-sized ones
+            const auto seg = [&](uint64_t i) { return small + 100 + static_cast<uint32_t>((i - 3) * mss); };
+
+            TCPSenderTestHarness test {"A short hole is resent past a SACKed segment too big for the window",
+                                       cfg,
+                                       CongestionControl::Reno};
+            test.execute(Push {});
+            test.execute(ExpectMessage {}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(60000));
+            test.execute(Push {string(2 * mss, 'x')});
+            test.execute(Push {string(100, 'x')});
+            test.execute(Push {string(5 * mss, 'x')});
+            test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(isn + 1));
+            test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(isn + 1 + mss));
+            test.execute(ExpectMessage {}.with_payload_size(100).with_seqno(small));
+            for (uint64_t i = 3; i < 8; ++i) {
+                test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(seg(i)));
+            }
+
+            /* the first segment and the short one are lost. Resending the first leaves room for less than the
+               SACKed segment after it, but enough for the short one. */
+            test.execute(AckReceived {Wrap32 {isn + 1}}
+                           .with_win(60000)
+                           .with_sack(isn + 1 + mss, small)
+                           .with_sack(seg(3), seg(6)));
+            test.execute(ExpectMessage {}.with_payload_size(mss).with_seqno(isn + 1));
+            test.execute(ExpectMessage {}.with_payload_size(100).with_seqno(small));
+            test.execute(ExpectNoSegment {});
+        }
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
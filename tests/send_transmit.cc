@@ -166,6 +166,78 @@ int main() {
             test.execute(ExpectSeqno {Wrap32 {isn + 1 + 3}});
         }
 
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+            cfg.mss = 1460;
+
+            TCPSenderTestHarness test {"Segments shrink to the peer's MSS", cfg};
+            test.execute(Push {});
+            test.execute(ExpectMessage {}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(10000).with_mss(536));
+            test.execute(Push {string(2000, 'x')});
+            test.execute(ExpectMessage {}.with_payload_size(536).with_seqno(isn + 1));
+            test.execute(ExpectMessage {}.with_payload_size(536).with_seqno(isn + 1 + 536));
+            test.execute(ExpectMessage {}.with_payload_size(536).with_seqno(isn + 1 + 1072));
+            test.execute(ExpectMessage {}.with_payload_size(392).with_seqno(isn + 1 + 1608));
+            test.execute(ExpectNoSegment {});
+        }
+
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+            cfg.mss = 1460;
+
+            TCPSenderTestHarness test {"A server's segments shrink to the MSS on the peer's SYN", cfg};
+            test.execute(Receive {{{}, 10000}}.with_mss(536).without_push());
+            test.execute(Push {});
+            test.execute(ExpectMessage {}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(10000));
+            test.execute(Push {string(1000, 'x')});
+            test.execute(ExpectMessage {}.with_payload_size(536).with_seqno(isn + 1));
+            test.execute(ExpectMessage {}.with_payload_size(464).with_seqno(isn + 1 + 536));
+            test.execute(ExpectNoSegment {});
+        }
+
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+            cfg.mss = 1460;
+
+            TCPSenderTestHarness test {"Only the first MSS the peer gives counts", cfg};
+            test.execute(Push {});
+            test.execute(ExpectMessage {}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(10000).with_mss(536));
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(10000).with_mss(100));
+            test.execute(Push {string(600, 'x')});
+            test.execute(ExpectMessage {}.with_payload_size(536).with_seqno(isn + 1));
+            test.execute(ExpectMessage {}.with_payload_size(64).with_seqno(isn + 1 + 536));
+            test.execute(AckReceived {Wrap32 {isn + 601}}.with_win(10000).with_mss(1460));
+            test.execute(Push {string(600, 'x')});
+            test.execute(ExpectMessage {}.with_payload_size(536).with_seqno(isn + 601));
+            test.execute(ExpectMessage {}.with_payload_size(64).with_seqno(isn + 601 + 536));
+            test.execute(ExpectNoSegment {});
+        }
+
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+            cfg.mss = 1460;
+
+            TCPSenderTestHarness test {"Segments stay within our own MSS", cfg};
+            test.execute(Push {});
+            test.execute(ExpectMessage {}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(10000).with_mss(8960));
+            test.execute(Push {string(2000, 'x')});
+            test.execute(ExpectMessage {}.with_payload_size(1460).with_seqno(isn + 1));
+            test.execute(ExpectMessage {}.with_payload_size(540).with_seqno(isn + 1 + 1460));
+            test.execute(ExpectNoSegment {});
+        }
+
     } catch (const exception& e) {
         cerr << e.what() << endl;
         return 1;
@@ -139,6 +139,30 @@ int main() {
             test.execute(ExpectMessage {}.with_fin(true).with_data("4567"));
             test.execute(ExpectNoSegment {});
         }
+
+        {
+            TCPConfig cfg;
+            const Wrap32 isn(rd());
+            cfg.isn = isn;
+            cfg.send_capacity = 200'000;
+
+            TCPSenderTestHarness test {"Scaled window beyond 64 KiB", cfg};
+            test.execute(Push {});
+            test.execute(ExpectMessage {}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived {Wrap32 {isn + 1}}.with_win(1000).with_window_scale(7));
+            test.execute(Push {string(150'000, 'x')});
+            for (uint32_t i = 0; i < 128; ++i) {
+                test.execute(ExpectMessage {}.with_payload_size(1000).with_seqno(isn + 1 + i * 1000));
+            }
+            test.execute(ExpectNoSegment {});
+            test.execute(ExpectSeqnosInFlight {128'000});
+
+            test.execute(AckReceived {Wrap32 {isn + 1 + 128'000}}.with_win(200).with_window_scale(7));
+            for (uint32_t i = 128; i < 150; ++i) {
+                test.execute(ExpectMessage {}.with_payload_size(1000).with_seqno(isn + 1 + i * 1000));
+            }
+            test.execute(ExpectNoSegment {});
+        }
     } catch (const exception& e) {
         cerr << e.what() << endl;
         return 1;
@@ -72,6 +72,35 @@ struct ExpectConsecutiveRetransmissions : public ExpectNumber<SenderAndOutput, u
     uint64_t value(SenderAndOutput& ss) const override { return ss.sender.consecutive_retransmissions(); }
 };
 
+struct ExpectRTO : public ExpectNumber<SenderAndOutput, uint64_t> {
+    using ExpectNumber::ExpectNumber;
+    std::string name() const override { return "RTO_ms"; }
+    uint64_t value(SenderAndOutput& ss) const override { return ss.sender.RTO_ms(); }
+};
+
+struct ExpectSRTT : public ExpectNumber<SenderAndOutput, double> {
+    using ExpectNumber::ExpectNumber;
+    std::string name() const override { return "SRTT_ms"; }
+    double value(SenderAndOutput& ss) const override { return ss.sender.SRTT_ms(); }
+};
+
+struct ExpectRTTVAR : public ExpectNumber<SenderAndOutput, double> {
+    using ExpectNumber::ExpectNumber;
+    std::string name() const override { return "RTTVAR_ms"; }
+    double value(SenderAndOutput& ss) const override { return ss.sender.RTTVAR_ms(); }
+};
+
+struct ExpectCongestionWindow : public ExpectNumber<SenderAndOutput, uint64_t> {
+    using ExpectNumber::ExpectNumber;
+    std::string name() const override { return "congestion_window"; }
+    uint64_t value(SenderAndOutput& ss) const override {
+        if (not ss.sender.congestion_controller()) {
+            throw ExpectationViolation {"TCPSender has no congestion controller"};
+        }
+        return ss.sender.congestion_controller()->congestion_window();
+    }
+};
+
 struct ExpectNoSegment : public Expectation<SenderAndOutput> {
     std::string description() const override { return "nothing to send"; }
     void execute(SenderAndOutput& ss) const override {
@@ -125,6 +154,27 @@ struct Push : public Action<SenderAndOutput> {
     }
 };
 
+struct EnablePacing : public Action<SenderAndOutput> {
+    std::optional<double> rate_;
+
+    explicit EnablePacing(std::optional<double> rate = {}) : rate_(rate) {}
+    std::string description() const override {
+        return rate_.has_value() ? "pace at " + std::to_string(rate_.value()) + " bytes/ms" : "pace";
+    }
+    void execute(SenderAndOutput& ss) const override { ss.sender.enable_pacing(rate_); }
+};
+
+struct EnableFastOpen : public Action<SenderAndOutput> {
+    std::optional<std::string> cookie_;
+
+    explicit EnableFastOpen(std::optional<std::string> cookie = {}) : cookie_(move(cookie)) {}
+    std::string description() const override {
+        return cookie_.has_value() ? "enable Fast Open with cookie \"" + Printer::prettify(cookie_.value()) + "\""
+                                   : "enable Fast Open without a cookie";
+    }
+    void execute(SenderAndOutput& ss) const override { ss.sender.enable_fast_open(cookie_); }
+};
+
 struct Tick : public Action<SenderAndOutput> {
     uint64_t ms_;
     std::optional<bool> max_retx_exceeded_ {};
@@ -170,7 +220,17 @@ struct Receive : public Action<SenderAndOutput> {
     explicit Receive(TCPReceiverMessage msg) : msg_(msg) {}
     std::string description() const override {
         std::ostringstream desc;
-        desc << "receive(ack=" << to_string(msg_.ackno) << ", win=" << msg_.window_size << ")";
+        desc << "receive(ack=" << to_string(msg_.ackno) << ", win=" << msg_.window_size;
+        if (msg_.window_scale.has_value()) {
+            desc << "<<" << static_cast<int>(msg_.window_scale.value());
+        }
+        if (msg_.max_segment_size.has_value()) {
+            desc << ", mss=" << msg_.max_segment_size.value();
+        }
+        for (const auto& block : msg_.sack_blocks) {
+            desc << ", sack=[" << block.left << "," << block.right << ")";
+        }
+        desc << ")";
         if (push_) {
             desc << ", then push stream to TCPSender";
         }
@@ -182,6 +242,21 @@ struct Receive : public Action<SenderAndOutput> {
         return *this;
     }
 
+    Receive& with_mss(uint16_t mss) {
+        msg_.max_segment_size = mss;
+        return *this;
+    }
+
+    Receive& with_window_scale(uint8_t window_scale) {
+        msg_.window_scale = window_scale;
+        return *this;
+    }
+
+    Receive& with_sack(Wrap32 left, Wrap32 right) {
+        msg_.sack_blocks.push_back({left, right});
+        return *this;
+    }
+
     void execute(SenderAndOutput& ss) const override {
         ss.sender.receive(msg_);
         if (push_) {
@@ -207,9 +282,11 @@ struct ExpectMessage : public Expectation<SenderAndOutput> {
     std::optional<bool> syn {};
     std::optional<bool> fin {};
     std::optional<bool> rst {};
+    std::optional<bool> sack_permitted {};
     std::optional<Wrap32> seqno {};
     std::optional<std::string> data {};
     std::optional<size_t> payload_size {};
+    std::optional<std::optional<std::string>> fast_open_cookie {};
 
     ExpectMessage& with_syn(bool syn_) {
         syn = syn_;
@@ -231,6 +308,11 @@ struct ExpectMessage : public Expectation<SenderAndOutput> {
         return *this;
     }
 
+    ExpectMessage& with_sack_permitted(bool sack_permitted_) {
+        sack_permitted = sack_permitted_;
+        return *this;
+    }
+
     ExpectMessage& with_seqno(Wrap32 seqno_) {
         seqno = seqno_;
         return *this;
@@ -248,6 +330,11 @@ struct ExpectMessage : public Expectation<SenderAndOutput> {
         return *this;
     }
 
+    ExpectMessage& with_fast_open_cookie(std::optional<std::string> cookie_) {
+        fast_open_cookie = std::move(cookie_);
+        return *this;
+    }
+
     std::string message_description() const {
         std::ostringstream o;
         if (seqno.has_value()) {
@@ -272,6 +359,16 @@ struct ExpectMessage : public Expectation<SenderAndOutput> {
         if (rst.has_value()) {
             o << (rst.value() ? " +RST" : " (no RST)");
         }
+        if (sack_permitted.has_value()) {
+            o << (sack_permitted.value() ? " +SACK-permitted" : " (no SACK-permitted)");
+        }
+        if (fast_open_cookie.has_value()) {
+            if (fast_open_cookie->has_value()) {
+                o << " Fast Open cookie=\"" << Printer::prettify(fast_open_cookie->value()) << "\"";
+            } else {
+                o << " (no Fast Open cookie)";
+            }
+        }
         return o.str();
     }
 
@@ -297,13 +394,23 @@ struct ExpectMessage : public Expectation<SenderAndOutput> {
         if (rst.has_value() and seg.RST != rst.value()) {
             throw ExpectationViolation("RST flag", rst.value(), seg.RST);
         }
+        if (sack_permitted.has_value() and seg.SACK_permitted != sack_permitted.value()) {
+            throw ExpectationViolation("SACK-permitted option", sack_permitted.value(), seg.SACK_permitted);
+        }
         if (seqno.has_value() and seg.seqno != seqno.value()) {
             throw ExpectationViolation("sequence number", seqno.value(), seg.seqno);
         }
+        if (fast_open_cookie.has_value() and seg.fast_open_cookie != fast_open_cookie.value()) {
+            const auto show = [](const std::optional<std::string>& cookie) {
+                return cookie.has_value() ? "\"" + Printer::prettify(cookie.value()) + "\"" : std::string {"none"};
+            };
+            throw ExpectationViolation("Fast Open cookie should have been " + show(fast_open_cookie.value())
+                                       + ", but was " + show(seg.fast_open_cookie));
+        }
         if (payload_size.has_value() and seg.payload.size() != payload_size.value()) {
             throw ExpectationViolation("payload_size", payload_size.value(), seg.payload.size());
         }
-        if (seg.payload.size() > TCPConfig::MAX_PAYLOAD_SIZE) {
+        if (seg.payload.size() > ss.sender.max_payload_size()) {
             throw ExpectationViolation("payload has length (" + std::to_string(seg.payload.size())
                                        + ") greater than the maximum");
         }
@@ -321,5 +428,34 @@ class TCPSenderTestHarness : public TestHarness<SenderAndOutput> {
     TCPSenderTestHarness(std::string name, TCPConfig config)
       : TestHarness(move(name),
                     "initial_RTO_ms=" + to_string(config.rt_timeout),
-                    {TCPSender {ByteStream {config.send_capacity}, config.isn, config.rt_timeout}}) {}
+                    {TCPSender {ByteStream {config.send_capacity},
+                                config.isn,
+                                config.rt_timeout,
+                                {},
+                                nullptr,
+                                config.mss}}) {}
+
+    // A sender that estimates its RTO from RTT samples, within `bounds`
+    TCPSenderTestHarness(std::string name, TCPConfig config, TCPSender::RTOBounds bounds)
+      : TestHarness(move(name),
+                    "initial_RTO_ms=" + to_string(config.rt_timeout) + ", RTO bounds=[" + to_string(bounds.min_ms)
+                      + ", " + to_string(bounds.max_ms) + "]",
+                    {TCPSender {ByteStream {config.send_capacity},
+                                config.isn,
+                                config.rt_timeout,
+                                bounds,
+                                nullptr,
+                                config.mss}}) {}
+
+    // A sender with a fixed RTO whose window is also limited by `algorithm`
+    TCPSenderTestHarness(std::string name, TCPConfig config, CongestionControl algorithm)
+      : TestHarness(move(name),
+                    "initial_RTO_ms=" + to_string(config.rt_timeout) + ", congestion control="
+                      + std::string {to_string(algorithm)},
+                    {TCPSender {ByteStream {config.send_capacity},
+                                config.isn,
+                                config.rt_timeout,
+                                {},
+                                make_congestion_controller(algorithm, config.mss),
+                                config.mss}}) {}
 };
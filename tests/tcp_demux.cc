@@ -0,0 +1,124 @@
+#include "exception.hh"
+#include "random.hh"
+#include "tcp_demux.hh"
+#include "tcp_demux_common.hh"
+
+#include <sys/socket.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+namespace {
+struct FourTupleHash {
+    size_t operator()(const FourTuple& t) const {
+        return hash<uint64_t> {}((uint64_t {t.remote_address} << 32 | t.local_address)
+                                 ^ (uint64_t {t.remote_port} << 16 | t.local_port));
+    }
+};
+
+// Compare against std::unordered_map under random inserts and erases
+void table_test() {
+    auto rd = get_random_engine();
+    const auto keys = random_four_tuples(rd, 5000);
+
+    ConnectionTable table;
+    unordered_map<FourTuple, uint32_t, FourTupleHash> expected;
+    for (size_t i = 0; i < 200000; ++i) {
+        const auto& key = keys[rd() % keys.size()];
+        const auto connection = static_cast<uint32_t>(i);
+        if (rd() % 3) {
+            if (table.insert(key, connection) != expected.emplace(key, connection).second) {
+                throw runtime_error("ConnectionTable insert disagrees with std::unordered_map");
+            }
+        } else if (table.erase(key) != static_cast<bool>(expected.erase(key))) {
+            throw runtime_error("ConnectionTable erase disagrees with std::unordered_map");
+        }
+
+        if (table.size() != expected.size()) {
+            throw runtime_error("ConnectionTable size disagrees with std::unordered_map");
+        }
+    }
+
+    for (const auto& key : keys) {
+        const auto it = expected.find(key);
+        if (table.find(key) != (it == expected.end() ? nullopt : optional {it->second})) {
+            throw runtime_error("ConnectionTable find disagrees with std::unordered_map");
+        }
+    }
+}
+
+// A segment from a peer reaches only the connection its 4-tuple names
+void dispatch_test() {
+    array<int, 2> fds {};
+    CheckSystemCall("socketpair", ::socketpair(AF_UNIX, SOCK_DGRAM, 0, fds.data()));
+    TCPOverIPv4Demultiplexer demux {FileDescriptor {fds[0]}, 1500};
+    FileDescriptor wire {fds[1]};
+
+    FdAdapterConfig first;
+    first.source = Address {"169.254.144.9", 1234};
+    first.destination = Address {"169.254.144.1", 80};
+    FdAdapterConfig second = first;
+    second.source = Address {"169.254.144.9", 1235};
+
+    const auto first_number = demux.connect({}, first);
+    const auto second_number = demux.connect({}, second);
+
+    // each connect sent a SYN; answer the second one from the peer's side
+    vector<string> syn(2);
+    syn.front().resize(IPv4Header::LENGTH);
+    wire.read(syn);
+    wire.read(syn);
+    const auto syn_tuple = TCPOverIPv4Demultiplexer::four_tuple(syn);
+    if (not syn_tuple.has_value() or syn_tuple->local_port != 80 or syn_tuple->remote_port != 1235) {
+        throw runtime_error("second SYN did not come from the second connection");
+    }
+
+    TCPOverIPv4Adapter peer;
+    peer.config_mut().source = second.destination;
+    peer.config_mut().destination = second.source;
+    TCPMessage syn_ack;
+    syn_ack.sender.SYN = true;
+    syn_ack.sender.seqno = Wrap32 {1000};
+    syn_ack.receiver.ackno = demux.peer(second_number).sender().make_empty_message().seqno;
+    syn_ack.receiver.window_size = 1000;
+    wire.write(serialize(peer.wrap_tcp_in_ip(syn_ack)));
+
+    if (demux.read() != optional {second_number} or not demux.peer(second_number).has_ackno()
+        or demux.peer(first_number).has_ackno()) {
+        throw runtime_error("SYN-ACK was not delivered to exactly the second connection");
+    }
+
+    // once the connection is erased, its segments are dropped
+    demux.erase(second_number);
+    wire.write(serialize(peer.wrap_tcp_in_ip(syn_ack)));
+    if (demux.read().has_value() or demux.size() != 1) {
+        throw runtime_error("segment for an erased connection was delivered");
+    }
+}
+
+} // namespace
+
+int main() {
+    try {
+        table_test();
+        dispatch_test();
+    } catch (const exception& e) {
+        cerr << "Exception: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
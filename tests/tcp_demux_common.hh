@@ -0,0 +1,84 @@
+#pragma once
+
+#include "address.hh"
+#include "exception.hh"
+#include "tcp_demux.hh"
+
+#include <sys/socket.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+// Many clients of one server port: the shape of table a busy listener builds
+inline std::vector<FourTuple> random_four_tuples(std::default_random_engine& rd, size_t count) {
+    const uint32_t server = Address {"169.254.144.9"}.ipv4_numeric();
+    std::vector<FourTuple> ret;
+    ret.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        ret.push_back({.local_address = server,
+                       .remote_address = static_cast<uint32_t>(0x0a000000 | (rd() & 0xffff)),
+                       .local_port = 80,
+                       .remote_port = static_cast<uint16_t>(rd())});
+    }
+    return ret;
+}
+
+// Two demultiplexers joined by a socketpair, like two hosts on one link
+struct Link {
+    TCPOverIPv4Demultiplexer client;
+    TCPOverIPv4Demultiplexer server;
+
+    static Link make() {
+        std::array<int, 2> fds {};
+        CheckSystemCall("socketpair", ::socketpair(AF_UNIX, SOCK_DGRAM, 0, fds.data()));
+        Link link {TCPOverIPv4Demultiplexer {FileDescriptor {fds[0]}, 1500},
+                   TCPOverIPv4Demultiplexer {FileDescriptor {fds[1]}, 1500}};
+        link.client.fd().set_blocking(false);
+        link.server.fd().set_blocking(false);
+        return link;
+    }
+
+    // read everything waiting for one side; returns whether there was anything
+    static bool drain(TCPOverIPv4Demultiplexer& demux) {
+        bool any = false;
+        for (auto reads = demux.fd().read_count();; reads = demux.fd().read_count()) {
+            demux.read();
+            if (demux.fd().read_count() == reads) {
+                return any;
+            }
+            any = true;
+        }
+    }
+
+    void pump() {
+        while (drain(server) | drain(client)) {}
+    }
+
+    size_t connect(uint16_t client_port, const std::string& client_address = "169.254.144.1") {
+        FdAdapterConfig config;
+        config.source = Address {client_address, client_port};
+        config.destination = Address {"169.254.144.9", 80};
+        return client.connect({}, config);
+    }
+
+    size_t accept_all(size_t listener) {
+        size_t accepted = 0;
+        while (server.accept(listener).has_value()) {
+            ++accepted;
+        }
+        return accepted;
+    }
+};
+
+inline ListenerConfig listener_config(size_t backlog, size_t syn_backlog, bool syn_cookies) {
+    ListenerConfig config;
+    config.local = Address {"169.254.144.9", 80};
+    config.backlog = backlog;
+    config.syn_backlog = syn_backlog;
+    config.syn_cookies = syn_cookies;
+    return config;
+}
@@ -0,0 +1,225 @@
+#include "tcp_demux.hh"
+#include "tcp_demux_common.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+// Open and accept connections as fast as a client in the same process can ask for them
+void connection_rate_test(const size_t num_connections, const bool syn_cookies) {
+    constexpr size_t concurrent = 4; // well within a socketpair's queue of datagrams
+    auto link = Link::make();
+    const auto config = listener_config(concurrent, syn_cookies ? 0 : concurrent, syn_cookies);
+    const auto listener = link.server.listen({}, config);
+
+    size_t accepted = 0;
+    vector<size_t> clients;
+    const auto start_time = steady_clock::now();
+    for (size_t opened = 0; opened < num_connections; opened += concurrent) {
+        clients.clear();
+        for (size_t i = 0; i < concurrent; ++i) {
+            clients.push_back(link.connect(static_cast<uint16_t>(1024 + (opened + i) % 60000)));
+        }
+        link.pump();
+        while (const auto connection = link.server.accept(listener)) {
+            link.server.erase(connection.value());
+            ++accepted;
+        }
+        for (const auto client : clients) {
+            link.client.erase(client);
+        }
+    }
+    const auto stop_time = steady_clock::now();
+
+    if (accepted != num_connections) {
+        throw runtime_error("accepted " + to_string(accepted) + " of " + to_string(num_connections)
+                            + " connections");
+    }
+
+    const auto test_duration = duration_cast<duration<double>>(stop_time - start_time);
+    const auto connections_per_second = static_cast<double>(num_connections) / test_duration.count();
+
+    fstream debug_output;
+    debug_output.open("/dev/tty");
+
+    const string how = syn_cookies ? "with SYN cookies" : "through the SYN queue";
+    cout << "Listener accepted " << num_connections << " connections " << how << " at " << fixed
+         << setprecision(0) << connections_per_second << " connections/s.\n";
+
+    debug_output << "      Connection rate (" << (syn_cookies ? "SYN cookies" : "SYN queue") << "): " << fixed
+                 << setprecision(0) << connections_per_second << " /s\n";
+
+    if (connections_per_second < 1000) {
+        throw runtime_error("Listener did not meet minimum speed of 1000 connections/s.");
+    }
+}
+
+// Memory mappings of the process; each stream that has carried data holds two (its mirrored ring)
+size_t memory_mappings() {
+    ifstream maps {"/proc/self/maps"};
+    size_t count = 0;
+    for (string line; getline(maps, line);) {
+        ++count;
+    }
+    return count;
+}
+
+// Hold `num_connections` real connections, a TCPPeer at each end, then hand ACKs to the server's peers. Idle
+// streams map no ring, so the count is bounded by memory rather than vm.max_map_count.
+void peer_count_test(const size_t num_connections, const size_t num_datagrams, const size_t random_seed) {
+    constexpr size_t concurrent = 4;
+    constexpr size_t ports_per_address = 60000;
+    auto link = Link::make();
+    const auto listener = link.server.listen({}, listener_config(concurrent, concurrent, false));
+    const size_t mappings_before = memory_mappings();
+
+    vector<size_t> clients;
+    clients.reserve(num_connections);
+    size_t accepted = 0;
+    const auto open_start = steady_clock::now();
+    for (size_t opened = 0; opened < num_connections; opened += concurrent) {
+        for (size_t i = opened; i < min(opened + concurrent, num_connections); ++i) {
+            const auto client_address = "169.254.145." + to_string(1 + i / ports_per_address);
+            clients.push_back(link.connect(static_cast<uint16_t>(1024 + i % ports_per_address), client_address));
+        }
+        link.pump();
+        accepted += link.accept_all(listener);
+    }
+    const auto open_stop = steady_clock::now();
+
+    if (accepted != num_connections) {
+        throw runtime_error("accepted " + to_string(accepted) + " of " + to_string(num_connections)
+                            + " connections");
+    }
+    const size_t mappings_after = memory_mappings();
+    const size_t mappings = mappings_after - min(mappings_after, mappings_before);
+
+    // pure ACKs from random clients, as their peers would send them
+    default_random_engine rd {random_seed};
+    vector<vector<string>> datagrams;
+    for (size_t i = 0; i < 1024; ++i) {
+        const auto client = clients[rd() % clients.size()];
+        TCPOverIPv4Adapter adapter;
+        adapter.config_mut() = link.client.config(client);
+        const auto& peer = link.client.peer(client);
+        const TCPMessage ack {peer.sender().make_empty_message(), peer.receiver().send()};
+        datagrams.push_back(adapter.serialize_tcp_in_ip(ack));
+    }
+
+    size_t delivered = 0;
+    const auto start_time = steady_clock::now();
+    for (size_t i = 0; i < num_datagrams; ++i) {
+        delivered += link.server.receive(datagrams[i % datagrams.size()]).has_value();
+    }
+    const auto stop_time = steady_clock::now();
+
+    if (delivered != num_datagrams) {
+        throw runtime_error("a datagram did not reach its connection");
+    }
+
+    const auto open_duration = duration_cast<duration<double>>(open_stop - open_start);
+    const auto test_duration = duration_cast<duration<double>>(stop_time - start_time);
+    const auto datagrams_per_second = static_cast<double>(num_datagrams) / test_duration.count();
+
+    fstream debug_output;
+    debug_output.open("/dev/tty");
+
+    cout << "Demultiplexer held " << link.server.size() << " connections to TCPPeers (opened in " << fixed
+         << setprecision(2) << open_duration.count() << " s, " << mappings << " new memory mappings) and delivered "
+         << datagrams_per_second / 1e6 << " million ACKs/s.\n";
+
+    debug_output << "               Delivery to peers: " << fixed << setprecision(2) << datagrams_per_second / 1e6
+                 << " million/s\n";
+
+    if (datagrams_per_second < 1e5) {
+        throw runtime_error("Demultiplexer did not meet minimum speed of 100,000 datagrams/s to its peers.");
+    }
+}
+
+void speed_test(const size_t num_connections, // NOLINT(bugprone-easily-swappable-parameters)
+                const size_t num_lookups,     // NOLINT(bugprone-easily-swappable-parameters)
+                const size_t random_seed)
+{
+    default_random_engine rd {random_seed};
+    auto keys = random_four_tuples(rd, num_connections);
+
+    ConnectionTable table;
+    const auto load_start = steady_clock::now();
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (not table.insert(keys[i], static_cast<uint32_t>(i))) {
+            keys[i] = keys[i - 1];
+        }
+    }
+    const auto load_stop = steady_clock::now();
+
+    // serialized datagrams from random connections, as the TUN reader would see them
+    TCPOverIPv4Adapter adapter;
+    vector<vector<string>> datagrams;
+    for (size_t i = 0; i < 1024; ++i) {
+        const auto& key = keys[rd() % keys.size()];
+        adapter.config_mut().source
+          = Address {Address::from_ipv4_numeric(key.remote_address).ip(), key.remote_port};
+        adapter.config_mut().destination
+          = Address {Address::from_ipv4_numeric(key.local_address).ip(), key.local_port};
+        datagrams.push_back(serialize(adapter.wrap_tcp_in_ip({})));
+    }
+
+    size_t matched = 0;
+    const auto start_time = steady_clock::now();
+    for (size_t i = 0; i < num_lookups; ++i) {
+        const auto key = TCPOverIPv4Demultiplexer::four_tuple(datagrams[i % datagrams.size()]);
+        matched += table.find(key.value()).has_value();
+    }
+    const auto stop_time = steady_clock::now();
+
+    if (matched != num_lookups) {
+        throw runtime_error("ConnectionTable lost a connection");
+    }
+
+    const auto load_duration = duration_cast<duration<double>>(load_stop - load_start);
+    const auto test_duration = duration_cast<duration<double>>(stop_time - start_time);
+    const auto lookups_per_second = static_cast<double>(num_lookups) / test_duration.count();
+    const auto megabytes = static_cast<double>(table.memory_usage()) / 1e6;
+
+    fstream debug_output;
+    debug_output.open("/dev/tty");
+
+    cout << "ConnectionTable with " << table.size() << " connections (loaded in " << fixed << setprecision(3)
+         << load_duration.count() << " s, " << setprecision(2) << megabytes << " MB) demultiplexed "
+         << lookups_per_second / 1e6 << " million datagrams/s.\n";
+
+    debug_output << "             Demultiplexing rate: " << fixed << setprecision(2) << lookups_per_second / 1e6
+                 << " million/s\n";
+
+    if (lookups_per_second < 1e6) {
+        throw runtime_error("ConnectionTable did not meet minimum speed of 1 million lookups/s.");
+    }
+}
+
+void program_body() {
+    speed_test(100000, 5e7, 1492);
+    peer_count_test(100000, 5e6, 1492);
+    connection_rate_test(20000, false);
+    connection_rate_test(20000, true);
+}
+
+int main() {
+    try {
+        program_body();
+    } catch (const exception& e) {
+        cerr << "Exception: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,145 @@
+#include "tcp_demux.hh"
+#include "tcp_demux_common.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+// The SYN and accept queues are bounded, SYNs beyond them are retried, and SYN cookies complete without state
+void listen_test() {
+    {
+        auto link = Link::make();
+        const auto listener = link.server.listen({}, listener_config(2, 2, false));
+        for (uint16_t port = 1000; port < 1004; ++port) {
+            link.connect(port);
+        }
+        Link::drain(link.server);
+        if (link.server.size() != 2) {
+            throw runtime_error("SYN queue of 2 held " + to_string(link.server.size()) + " connections");
+        }
+        link.pump();
+        if (link.accept_all(listener) != 2) {
+            throw runtime_error("the two half-open connections did not complete");
+        }
+
+        // the dropped SYNs are retransmitted and get in
+        link.client.tick(TCPConfig::TIMEOUT_DFLT);
+        link.pump();
+        if (link.accept_all(listener) != 2 or link.server.size() != 4) {
+            throw runtime_error("retransmitted SYNs were not accepted");
+        }
+    }
+
+    {
+        auto link = Link::make();
+        const auto listener = link.server.listen({}, listener_config(8, 1, true));
+        vector<size_t> clients;
+        for (uint16_t port = 1000; port < 1004; ++port) {
+            clients.push_back(link.connect(port));
+        }
+        link.pump();
+
+        vector<size_t> accepted;
+        while (const auto connection = link.server.accept(listener)) {
+            accepted.push_back(connection.value());
+        }
+        if (accepted.size() != 4) {
+            throw runtime_error("SYN cookies accepted " + to_string(accepted.size()) + " of 4 connections");
+        }
+
+        // a connection opened from a cookie carries data both ways
+        link.client.peer(clients.back()).outbound_writer().push("hello");
+        link.client.push(clients.back());
+        link.server.peer(accepted.back()).outbound_writer().push("world");
+        link.server.push(accepted.back());
+        link.pump();
+        auto& server_inbound = link.server.peer(accepted.back()).inbound_reader();
+        auto& client_inbound = link.client.peer(clients.back()).inbound_reader();
+        if (server_inbound.peek() != "hello" or client_inbound.peek() != "world") {
+            throw runtime_error("data did not cross a connection opened from a SYN cookie");
+        }
+    }
+
+    {
+        // a cookie keeps the MSS of the SYN it answers, and a peer that changes the MSS it encodes is refused
+        auto link = Link::make();
+        const auto listener = link.server.listen({}, listener_config(8, 1, true));
+        link.connect(1000);
+        Link::drain(link.server);
+        TCPConfig small_mss;
+        small_mss.mss = 536;
+        FdAdapterConfig config;
+        config.source = Address {"169.254.144.1", 1001};
+        config.destination = Address {"169.254.144.9", 80};
+        const auto client = link.client.connect(small_mss, config);
+        Link::drain(link.server);
+        Link::drain(link.client);
+
+        const auto& peer = link.client.peer(client);
+        TCPMessage forged {peer.sender().make_empty_message(), peer.receiver().send()};
+        forged.receiver.ackno = forged.receiver.ackno.value() + (1U << 24); // the next MSS a cookie can encode
+        TCPOverIPv4Adapter adapter;
+        adapter.config_mut() = config;
+        if (link.server.receive(adapter.serialize_tcp_in_ip(forged)).has_value()) {
+            throw runtime_error("a cookie whose MSS was changed was accepted");
+        }
+
+        link.pump();
+        optional<size_t> accepted;
+        while (const auto connection = link.server.accept(listener)) {
+            if (link.server.config(connection.value()).destination.port() == 1001) {
+                accepted = connection;
+            }
+        }
+        if (not accepted.has_value()) {
+            throw runtime_error("the connection with a 536-byte MSS was not accepted");
+        }
+        link.server.peer(accepted.value()).outbound_writer().push(string(2000, 'x'));
+        link.server.push(accepted.value());
+        size_t largest = 0;
+        for (string datagram; link.client.fd().read(datagram), not datagram.empty(); datagram.clear()) {
+            largest = max(largest, datagram.size() - IPv4Header::LENGTH - TCPSegment::MIN_HEADER_LENGTH);
+        }
+        if (largest != 536) {
+            throw runtime_error("a connection from a cookie for a 536-byte MSS sent " + to_string(largest)
+                                + "-byte segments");
+        }
+    }
+
+    {
+        auto link = Link::make();
+        link.server.listen({}, listener_config(8, 8, false));
+        const auto client = link.connect(1000);
+        Link::drain(link.server);
+        link.client.erase(client);
+        for (size_t ms = 0; ms < 300000 and link.server.size() > 0; ms += TCPConfig::TIMEOUT_DFLT) {
+            link.server.tick(TCPConfig::TIMEOUT_DFLT);
+            Link::drain(link.client);
+        }
+        if (link.server.size() != 0) {
+            throw runtime_error("a half-open connection whose SYN-ACK went unanswered was kept");
+        }
+    }
+}
+} // namespace
+
+int main() {
+    try {
+        listen_test();
+    } catch (const exception& e) {
+        cerr << "Exception: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,125 @@
+#include "tcp_over_ip.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+FdAdapterConfig adapter_config(uint16_t source_port, uint16_t destination_port) {
+    FdAdapterConfig config;
+    config.source = Address {"169.254.144.1", source_port};
+    config.destination = Address {"169.254.144.9", destination_port};
+    return config;
+}
+
+// Datagrams of 1460-byte segments from one connection's sender, parsed as far as the IPv4 header
+vector<InternetDatagram> datagrams_from(const FdAdapterConfig& config, size_t count, default_random_engine& rd) {
+    TCPOverIPv4Adapter sender;
+    sender.config_mut() = config;
+    vector<InternetDatagram> ret(count);
+    for (auto& datagram : ret) {
+        TCPMessage msg;
+        msg.sender.seqno = Wrap32 {static_cast<uint32_t>(rd())};
+        msg.sender.payload = string(TCPConfig::MAX_PAYLOAD_SIZE, static_cast<char>(rd()));
+        msg.receiver.ackno = Wrap32 {static_cast<uint32_t>(rd())};
+        msg.receiver.window_size = static_cast<uint16_t>(rd());
+        if (not parse(datagram, sender.serialize_tcp_in_ip(msg))) {
+            throw runtime_error("could not parse a datagram");
+        }
+    }
+    return ret;
+}
+
+TCPOverIPv4Adapter receiver_of(const FdAdapterConfig& sender_config) {
+    TCPOverIPv4Adapter receiver;
+    receiver.config_mut().source = sender_config.destination;
+    receiver.config_mut().destination = sender_config.source;
+    return receiver;
+}
+
+// Parse the whole segment, checksum included, before looking at its ports
+optional<TCPMessage> reference_unwrap(const FdAdapterConfig& config, const InternetDatagram& ip_dgram) {
+    TCPSegment tcp_seg;
+    if (not parse(tcp_seg, ip_dgram.payload, ip_dgram.header.pseudo_checksum())
+        or tcp_seg.udinfo.dst_port != config.source.port()
+        or tcp_seg.udinfo.src_port != config.destination.port()) {
+        return {};
+    }
+    return tcp_seg.message;
+}
+
+template<typename Unwrap>
+double datagrams_per_second(const vector<InternetDatagram>& datagrams,
+                            const size_t rounds,
+                            const bool expect_accepted,
+                            const Unwrap& unwrap)
+{
+    const auto start_time = steady_clock::now();
+    for (size_t round = 0; round < rounds; ++round) {
+        for (const auto& datagram : datagrams) {
+            if (unwrap(datagram).has_value() != expect_accepted) {
+                throw runtime_error(expect_accepted ? "a datagram was rejected" : "a datagram was accepted");
+            }
+        }
+    }
+    const auto test_duration = duration_cast<duration<double>>(steady_clock::now() - start_time);
+    return static_cast<double>(datagrams.size() * rounds) / test_duration.count();
+}
+
+void speed_test(const size_t num_datagrams, const size_t random_seed) {
+    default_random_engine rd {random_seed};
+    const auto ours = adapter_config(443, 80);
+    auto receiver = receiver_of(ours);
+    const auto own = datagrams_from(ours, 1000, rd);
+    const auto foreign = datagrams_from(adapter_config(444, 80), 1000, rd);
+    const size_t rounds = num_datagrams / own.size();
+
+    const double reject_rate = datagrams_per_second(
+      foreign, rounds, false, [&](const InternetDatagram& d) { return receiver.unwrap_tcp_in_ip(d); });
+    const double reference_reject_rate = datagrams_per_second(
+      foreign, rounds, false, [&](const InternetDatagram& d) { return reference_unwrap(receiver.config(), d); });
+    const double accept_rate = datagrams_per_second(
+      own, rounds, true, [&](const InternetDatagram& d) { return receiver.unwrap_tcp_in_ip(d); });
+    const double offload_rate = datagrams_per_second(
+      own, rounds, true, [&](const InternetDatagram& d) { return receiver.unwrap_tcp_in_ip(d, true); });
+
+    fstream debug_output;
+    debug_output.open("/dev/tty");
+
+    cout << fixed << setprecision(2) << "Rejected foreign datagrams at " << reject_rate / 1e6
+         << " million/s (after a full parse: " << reference_reject_rate / 1e6 << " million/s).\n"
+         << "Unwrapped 1460-byte segments at " << accept_rate / 1e6
+         << " million/s (checksum verified by the device: " << offload_rate / 1e6 << " million/s).\n";
+
+    debug_output << "      Foreign datagram rejection: " << fixed << setprecision(2) << reject_rate / 1e6
+                 << " million/s (" << reject_rate / reference_reject_rate << "x)\n";
+
+    if (reject_rate < reference_reject_rate) {
+        throw runtime_error("rejecting by 4-tuple was slower than parsing the whole segment");
+    }
+}
+
+void program_body() {
+    speed_test(1000000, 1492);
+}
+
+int main() {
+    try {
+        program_body();
+    } catch (const exception& e) {
+        cerr << "Exception: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,130 @@
+#include "random.hh"
+#include "tcp_over_ip.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+// Build a datagram field by field: the IPv4 header from the config, and the TCP segment serialized once for its
+// checksum and once more for the payload
+InternetDatagram reference_wrap(const FdAdapterConfig& config, const TCPMessage& msg) {
+    TCPSegment seg {.message = msg};
+    seg.udinfo.src_port = config.source.port();
+    seg.udinfo.dst_port = config.destination.port();
+
+    InternetDatagram ip_dgram;
+    ip_dgram.header.src = config.source.ipv4_numeric();
+    ip_dgram.header.dst = config.destination.ipv4_numeric();
+    ip_dgram.header.len = ip_dgram.header.hlen * 4 + seg.header_length() + seg.message.sender.payload.size();
+
+    seg.compute_checksum(ip_dgram.header.pseudo_checksum());
+    ip_dgram.header.compute_checksum();
+    ip_dgram.payload = serialize(seg);
+    return ip_dgram;
+}
+
+string concatenate(const vector<string>& buffers) {
+    string ret;
+    for (const auto& buffer : buffers) {
+        ret += buffer;
+    }
+    return ret;
+}
+
+FdAdapterConfig adapter_config(uint16_t source_port) {
+    FdAdapterConfig config;
+    config.source = Address {"169.254.144.9", source_port};
+    config.destination = Address {"169.254.144.1", 443};
+    return config;
+}
+
+// Segments without options, as an established connection sends them
+TCPMessage random_message(default_random_engine& rd) {
+    TCPMessage msg;
+    msg.sender.seqno = Wrap32 {static_cast<uint32_t>(rd())};
+    msg.sender.payload = string(rd() % 1461, 'x');
+    for (auto& c : msg.sender.payload) {
+        c = static_cast<char>(rd());
+    }
+    msg.sender.FIN = rd() % 8 == 0;
+    msg.sender.RST = rd() % 32 == 0;
+    if (rd() % 16 != 0) {
+        msg.receiver.ackno = Wrap32 {static_cast<uint32_t>(rd())};
+    }
+    msg.receiver.window_size = static_cast<uint16_t>(rd());
+    return msg;
+}
+
+// The template gives the same bytes as building each datagram field by field, through address changes
+void wrap_test(const size_t num_messages) {
+    auto rd = get_random_engine();
+    TCPOverIPv4Adapter adapter;
+    TCPOverIPv4Adapter receiver;
+    for (size_t i = 0; i < num_messages; ++i) {
+        if (i % 1000 == 0) {
+            adapter.config_mut() = adapter_config(static_cast<uint16_t>(1024 + i / 1000));
+            receiver.config_mut().source = adapter.config().destination;
+            receiver.config_mut().destination = adapter.config().source;
+        }
+        const auto msg = random_message(rd);
+        const auto bytes = concatenate(adapter.serialize_tcp_in_ip(msg));
+        const auto reference = concatenate(serialize(reference_wrap(adapter.config(), msg)));
+        if (bytes != reference or concatenate(serialize(adapter.wrap_tcp_in_ip(msg))) != reference) {
+            throw runtime_error("the header template built a different datagram");
+        }
+
+        InternetDatagram parsed;
+        if (not parse(parsed, vector<string> {bytes})) {
+            throw runtime_error("the datagram's IPv4 header did not parse");
+        }
+        const auto unwrapped = receiver.unwrap_tcp_in_ip(parsed);
+        if (not unwrapped.has_value() or unwrapped->sender.payload != msg.sender.payload
+            or unwrapped->sender.seqno != msg.sender.seqno or unwrapped->receiver.ackno != msg.receiver.ackno) {
+            throw runtime_error("the datagram's TCP segment did not parse");
+        }
+    }
+}
+
+// The window-scale and MSS options count only on a SYN: the same options on any other segment are ignored
+void options_test() {
+    TCPSegment seg;
+    seg.message.sender.SYN = true;
+    seg.message.receiver.ackno = Wrap32 {1};
+    seg.message.receiver.window_scale = 7;
+    seg.message.receiver.max_segment_size = 536;
+    auto bytes = concatenate(serialize(seg));
+
+    for (const bool syn : {true, false}) {
+        bytes.at(13) = static_cast<char>(syn ? bytes.at(13) | 0b0000'0010 : bytes.at(13) & ~0b0000'0010);
+        TCPSegment parsed;
+        if (not parse(parsed, vector<string> {bytes}, 0, false)) {
+            throw runtime_error("a segment with options did not parse");
+        }
+        const auto& receiver = parsed.message.receiver;
+        if (syn != receiver.window_scale.has_value() or syn != receiver.max_segment_size.has_value()) {
+            throw runtime_error(syn ? "a SYN's options were dropped" : "a non-SYN segment's options were taken");
+        }
+    }
+}
+} // namespace
+
+int main() {
+    try {
+        wrap_test(20000);
+        options_test();
+    } catch (const exception& e) {
+        cerr << "Exception: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
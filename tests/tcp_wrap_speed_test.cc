@@ -0,0 +1,105 @@
+#include "tcp_over_ip.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+// Build a datagram field by field: the IPv4 header from the config, and the TCP segment serialized once for its
+// checksum and once more for the payload
+InternetDatagram reference_wrap(const FdAdapterConfig& config, const TCPMessage& msg) {
+    TCPSegment seg {.message = msg};
+    seg.udinfo.src_port = config.source.port();
+    seg.udinfo.dst_port = config.destination.port();
+
+    InternetDatagram ip_dgram;
+    ip_dgram.header.src = config.source.ipv4_numeric();
+    ip_dgram.header.dst = config.destination.ipv4_numeric();
+    ip_dgram.header.len = ip_dgram.header.hlen * 4 + seg.header_length() + seg.message.sender.payload.size();
+
+    seg.compute_checksum(ip_dgram.header.pseudo_checksum());
+    ip_dgram.header.compute_checksum();
+    ip_dgram.payload = serialize(seg);
+    return ip_dgram;
+}
+
+FdAdapterConfig adapter_config(uint16_t source_port) {
+    FdAdapterConfig config;
+    config.source = Address {"169.254.144.9", source_port};
+    config.destination = Address {"169.254.144.1", 443};
+    return config;
+}
+
+// Wrap and serialize each message, as a writer to a TUN device does
+template<typename WrapAndSerialize>
+double segments_per_second(const vector<TCPMessage>& messages, const size_t rounds, const WrapAndSerialize& wrap) {
+    size_t bytes = 0;
+    const auto start_time = steady_clock::now();
+    for (size_t round = 0; round < rounds; ++round) {
+        for (const auto& msg : messages) {
+            bytes += wrap(msg).front().size();
+        }
+    }
+    const auto test_duration = duration_cast<duration<double>>(steady_clock::now() - start_time);
+    if (bytes == 0) {
+        throw runtime_error("no datagrams were built");
+    }
+    return static_cast<double>(messages.size() * rounds) / test_duration.count();
+}
+
+void speed_test(const size_t payload_size, const size_t num_segments, const size_t random_seed) {
+    default_random_engine rd {random_seed};
+    vector<TCPMessage> messages(1000);
+    for (auto& msg : messages) {
+        msg.sender.seqno = Wrap32 {static_cast<uint32_t>(rd())};
+        msg.sender.payload = string(payload_size, 'x');
+        msg.receiver.ackno = Wrap32 {static_cast<uint32_t>(rd())};
+        msg.receiver.window_size = static_cast<uint16_t>(rd());
+    }
+    const size_t rounds = num_segments / messages.size();
+
+    TCPOverIPv4Adapter adapter;
+    adapter.config_mut() = adapter_config(80);
+    const double template_rate = segments_per_second(
+      messages, rounds, [&](const TCPMessage& msg) { return adapter.serialize_tcp_in_ip(msg); });
+    const double reference_rate = segments_per_second(
+      messages, rounds, [&](const TCPMessage& msg) { return serialize(reference_wrap(adapter.config(), msg)); });
+
+    fstream debug_output;
+    debug_output.open("/dev/tty");
+
+    cout << fixed << setprecision(2) << "Header template wrapped " << payload_size << "-byte segments at "
+         << template_rate / 1e6 << " million/s (field by field: " << reference_rate / 1e6 << " million/s).\n";
+
+    debug_output << "      Wrap rate (" << payload_size << "-byte payload): " << fixed << setprecision(2)
+                 << template_rate / 1e6 << " million/s (" << template_rate / reference_rate << "x)\n";
+
+    if (template_rate < reference_rate) {
+        throw runtime_error("the header template was slower than building headers field by field");
+    }
+}
+
+void program_body() {
+    speed_test(0, 2000000, 1492);
+    speed_test(1460, 1000000, 1492);
+}
+
+int main() {
+    try {
+        program_body();
+    } catch (const exception& e) {
+        cerr << "Exception: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,151 @@
+#include "congestion_control.hh"
+#include "tcp_config.hh"
+#include "tcp_receiver.hh"
+#include "tcp_sender.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+
+using namespace std;
+using namespace std::chrono;
+
+// A millisecond-stepped simulation of one bulk transfer over a long, fat, loss-free path, with and without
+// window scaling. Without it the receiver's window is cut to 64 KiB, as when the peer's SYN did not carry
+// the window-scale option.
+struct Path {
+    uint64_t bytes_per_ms;
+    uint64_t one_way_delay_ms;
+    uint64_t queue_bytes;
+};
+
+constexpr uint64_t HEADER_BYTES = 40;
+
+double simulate(const CongestionControl algorithm,
+                const Path& path,
+                const uint64_t window_bytes,
+                const bool window_scaling,
+                const uint64_t duration_ms)
+{
+    TCPConfig cfg;
+    cfg.send_capacity = window_bytes;
+    cfg.recv_capacity = window_bytes;
+    TCPSender sender {ByteStream {cfg.send_capacity},
+                      cfg.isn,
+                      cfg.rt_timeout,
+                      TCPSender::RTOBounds {cfg.rt_timeout_min, cfg.rt_timeout_max},
+                      make_congestion_controller(algorithm, TCPConfig::MAX_PAYLOAD_SIZE)};
+    TCPReceiver receiver {Reassembler {ByteStream {cfg.recv_capacity}}};
+
+    deque<TCPSenderMessage> bottleneck_queue;
+    uint64_t queued_bytes = 0;
+    uint64_t link_credit = 0;
+    deque<pair<uint64_t, TCPSenderMessage>> forward_path;
+    deque<pair<uint64_t, TCPReceiverMessage>> reverse_path;
+
+    const auto transmit = [&](const TCPSenderMessage& msg) {
+        const uint64_t size = msg.payload.size() + HEADER_BYTES;
+        if (queued_bytes + size > path.queue_bytes) {
+            return;
+        }
+        queued_bytes += size;
+        bottleneck_queue.push_back(msg);
+    };
+
+    const string data(cfg.send_capacity, 'x');
+    uint64_t bytes_delivered = 0;
+
+    for (uint64_t now = 0; now < duration_ms; ++now) {
+        while (not reverse_path.empty() and reverse_path.front().first <= now) {
+            sender.receive(reverse_path.front().second);
+            reverse_path.pop_front();
+        }
+
+        link_credit += path.bytes_per_ms;
+        while (not bottleneck_queue.empty()
+               and bottleneck_queue.front().payload.size() + HEADER_BYTES <= link_credit) {
+            const uint64_t size = bottleneck_queue.front().payload.size() + HEADER_BYTES;
+            link_credit -= size;
+            queued_bytes -= size;
+            forward_path.emplace_back(now + path.one_way_delay_ms, move(bottleneck_queue.front()));
+            bottleneck_queue.pop_front();
+        }
+        if (bottleneck_queue.empty()) {
+            link_credit = 0;
+        }
+
+        while (not forward_path.empty() and forward_path.front().first <= now) {
+            receiver.receive(move(forward_path.front().second));
+            forward_path.pop_front();
+            auto ack = receiver.send();
+            if (not window_scaling) {
+                const uint64_t window = uint64_t {ack.window_size} << ack.window_scale.value_or(0);
+                ack.window_size = static_cast<uint16_t>(min<uint64_t>(window, UINT16_MAX));
+                ack.window_scale.reset();
+            }
+            reverse_path.emplace_back(now + path.one_way_delay_ms, move(ack));
+        }
+
+        bytes_delivered += receiver.reader().bytes_buffered();
+        receiver.reader().pop(receiver.reader().bytes_buffered());
+        sender.writer().push(data.substr(0, sender.writer().available_capacity()));
+
+        sender.push(transmit);
+        sender.tick(1, transmit);
+    }
+
+    return static_cast<double>(bytes_delivered) * 8 / static_cast<double>(duration_ms) / 1000;
+}
+
+void comparison(const Path& path, const uint64_t window_bytes, const uint64_t duration_ms) {
+    fstream debug_output;
+    debug_output.open("/dev/tty");
+
+    const double link_mbps = static_cast<double>(path.bytes_per_ms) * 8 / 1000;
+    const uint64_t rtt_ms = 2 * path.one_way_delay_ms;
+    const double unscaled_ceiling_mbps = static_cast<double>(UINT16_MAX) * 8 / static_cast<double>(rtt_ms) / 1000;
+    cout << "Simulated " << fixed << setprecision(0) << link_mbps << " Mbit/s link, " << rtt_ms << " ms RTT, "
+         << window_bytes << "-byte windows, " << duration_ms / 1000 << " s per run (64 KiB per RTT is "
+         << setprecision(1) << unscaled_ceiling_mbps << " Mbit/s):\n";
+
+    for (const auto algorithm : {CongestionControl::Reno, CongestionControl::Cubic, CongestionControl::BBR}) {
+        for (const bool window_scaling : {false, true}) {
+            const auto start_time = steady_clock::now();
+            const double goodput = simulate(algorithm, path, window_bytes, window_scaling, duration_ms);
+            const auto test_duration = duration_cast<duration<double>>(steady_clock::now() - start_time);
+
+            cout << "  " << setw(5) << to_string(algorithm) << (window_scaling ? "  scaled  " : "  64 KiB  ")
+                 << " goodput " << setw(5) << setprecision(1) << goodput << " Mbit/s  (simulated in "
+                 << setprecision(2) << test_duration.count() << " s)\n";
+
+            if (window_scaling and goodput < 2 * unscaled_ceiling_mbps) {
+                throw runtime_error("Congestion control " + string {to_string(algorithm)}
+                                    + " with a scaled window did not get well past the 64 KiB ceiling.");
+            }
+        }
+    }
+
+    debug_output << "   Window scaling comparison: done\n";
+}
+
+void program_body() {
+    comparison({12'500, 25, 625'000}, 4'000'000, 10'000);
+}
+
+int main() {
+    try {
+        program_body();
+    } catch (const exception& e) {
+        cerr << "Exception: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,140 @@
+#include "checksum.hh"
+
+#include <bit>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+// Each kernel returns the ones'-complement sum of the 16-bit words of `data` (even length) read in *host*
+// byte order, possibly not yet folded to 16 bits. Per RFC 1071 the byte order only swaps the folded result.
+using SumKernel = uint64_t (*)(const char* data, size_t len);
+
+uint64_t fold64(uint64_t sum) {
+    sum = (sum >> 32) + (sum & 0xffffffff);
+    sum = (sum >> 32) + (sum & 0xffffffff);
+    sum = (sum >> 16) + (sum & 0xffff);
+    sum = (sum >> 16) + (sum & 0xffff);
+    return sum;
+}
+
+// 64 bits at a time, with end-around carry
+uint64_t sum_words_scalar(const char* data, size_t len) {
+    uint64_t sum = 0;
+    for (; len >= 8; data += 8, len -= 8) {
+        uint64_t word {};
+        memcpy(&word, data, 8);
+        sum += word;
+        sum += sum < word;
+    }
+    for (; len >= 2; data += 2, len -= 2) {
+        uint16_t word {};
+        memcpy(&word, data, 2);
+        sum += word;
+        sum += sum < word;
+    }
+    return sum;
+}
+
+#if defined(__x86_64__)
+// 16-bit words are widened into 32-bit lanes; a lane gains at most 2 * 0xffff per block, so lanes are
+// drained into the 64-bit total well before they could overflow.
+constexpr size_t kBlocksPerDrain = 16384;
+
+uint64_t sum_words_sse2(const char* data, size_t len) {
+    uint64_t sum = 0;
+    const __m128i zero = _mm_setzero_si128();
+    while (len >= 16) {
+        __m128i acc = _mm_setzero_si128();
+        for (size_t n = 0; n < kBlocksPerDrain and len >= 16; ++n, data += 16, len -= 16) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data)); // NOLINT(*-reinterpret-cast)
+            acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(v, zero));
+            acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(v, zero));
+        }
+        alignas(16) uint32_t lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), acc); // NOLINT(*-reinterpret-cast)
+        for (const auto lane : lanes) {
+            sum += lane;
+        }
+    }
+    const auto tail = sum_words_scalar(data, len);
+    sum += tail;
+    return sum + (sum < tail);
+}
+
+__attribute__((target("avx2"))) uint64_t sum_words_avx2(const char* data, size_t len) {
+    uint64_t sum = 0;
+    const __m256i zero = _mm256_setzero_si256();
+    while (len >= 32) {
+        __m256i acc = _mm256_setzero_si256();
+        for (size_t n = 0; n < kBlocksPerDrain and len >= 32; ++n, data += 32, len -= 32) {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data)); // NOLINT(*-cast)
+            acc = _mm256_add_epi32(acc, _mm256_unpacklo_epi16(v, zero));
+            acc = _mm256_add_epi32(acc, _mm256_unpackhi_epi16(v, zero));
+        }
+        alignas(32) uint32_t lanes[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc); // NOLINT(*-reinterpret-cast)
+        for (const auto lane : lanes) {
+            sum += lane;
+        }
+    }
+    const auto tail = sum_words_sse2(data, len);
+    sum += tail;
+    return sum + (sum < tail);
+}
+#endif
+
+SumKernel select_kernel() {
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return sum_words_avx2;
+    }
+    return sum_words_sse2; // SSE2 is part of the x86-64 baseline
+#else
+    return sum_words_scalar;
+#endif
+}
+
+// Short inputs (e.g. headers) aren't worth the vector setup
+constexpr size_t kVectorThreshold = 64;
+
+} // namespace
+
+void InternetChecksum::add(string_view data) {
+    if (data.empty()) {
+        return;
+    }
+
+    // an odd number of bytes came before: the first byte is the low half of a word
+    if (parity_) {
+        sum_ += static_cast<uint8_t>(data.front());
+        data.remove_prefix(1);
+        parity_ = false;
+    }
+
+    const size_t even_len = data.size() & ~size_t {1};
+    if (even_len) {
+        static const SumKernel vector_kernel = select_kernel();
+        const SumKernel kernel = even_len >= kVectorThreshold ? vector_kernel : sum_words_scalar;
+
+        auto folded = static_cast<uint16_t>(fold64(kernel(data.data(), even_len)));
+        if constexpr (endian::native == endian::little) {
+            folded = static_cast<uint16_t>((folded >> 8) | (folded << 8));
+        }
+
+        // keep sum_ from overflowing across many calls
+        sum_ = (sum_ >> 16) + (sum_ & 0xffff) + folded;
+    }
+
+    // an odd byte is left over: it is the high half of a word
+    if (data.size() != even_len) {
+        sum_ += static_cast<uint16_t>(static_cast<uint8_t>(data.back()) << 8);
+        parity_ = true;
+    }
+}
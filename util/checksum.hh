@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
 //! The internet checksum algorithm
@@ -12,17 +13,19 @@ class InternetChecksum {
 
   public:
     explicit InternetChecksum(const uint32_t sum = 0) : sum_(sum) {}
-    void add(std::string_view data) {
-        for (const uint8_t i : data) {
-            uint16_t val = i;
-            if (not parity_) {
-                val <<= 8;
-            }
-            sum_ += val;
-            parity_ = !parity_;
-        }
+
+    //! Patch a checksum after one 16-bit word of the covered data changed from `old_word` to `new_word`
+    //! (RFC 1624, eqn. 3: HC' = ~(~HC + ~m + m'))
+    static uint16_t update(const uint16_t cksum, const uint16_t old_word, const uint16_t new_word) {
+        uint32_t sum = static_cast<uint16_t>(~cksum) + static_cast<uint16_t>(~old_word) + new_word;
+        sum = (sum >> 16) + (sum & 0xffff);
+        sum = (sum >> 16) + (sum & 0xffff);
+        return ~sum;
     }
 
+    //! Add bytes to the sum; consecutive calls behave as if the data were concatenated (odd lengths included)
+    void add(std::string_view data);
+
     uint16_t value() const {
         uint32_t ret = sum_;
 
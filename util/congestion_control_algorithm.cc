@@ -0,0 +1,31 @@
+#include "congestion_control_algorithm.hh"
+
+#include <array>
+#include <utility>
+
+using namespace std;
+
+namespace {
+constexpr array<pair<CongestionControl, string_view>, 4> names {{{CongestionControl::None, "none"},
+                                                                 {CongestionControl::Reno, "reno"},
+                                                                 {CongestionControl::Cubic, "cubic"},
+                                                                 {CongestionControl::BBR, "bbr"}}};
+} // namespace
+
+string_view to_string(const CongestionControl algorithm) {
+    for (const auto& [value, name] : names) {
+        if (value == algorithm) {
+            return name;
+        }
+    }
+    return "unknown";
+}
+
+optional<CongestionControl> congestion_control_from_name(const string_view name) {
+    for (const auto& [value, value_name] : names) {
+        if (value_name == name) {
+            return value;
+        }
+    }
+    return {};
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+//! The congestion-control algorithms a TCPSender can use (make_congestion_controller builds them)
+enum class CongestionControl : uint8_t {
+    None,  //!< limited only by the receiver's window
+    Reno,  //!< RFC 5681
+    Cubic, //!< RFC 9438
+    BBR,   //!< a simplified BBR (model-based, ignores isolated losses)
+};
+
+//! The algorithm's name, as congestion_control_from_name takes it
+std::string_view to_string(CongestionControl algorithm);
+
+//! The algorithm with the given name ("none", "reno", "cubic" or "bbr"), if any
+std::optional<CongestionControl> congestion_control_from_name(std::string_view name);
@@ -142,6 +142,33 @@ void FileDescriptor::read(vector<string>& buffers) {
     }
 }
 
+// buffer is the space to be read into
+size_t FileDescriptor::read_into(span<char> buffer) {
+    if (buffer.empty()) {
+        return 0;
+    }
+
+    const ssize_t bytes_read = ::read(fd_num(), buffer.data(), buffer.size());
+    if (bytes_read < 0) {
+        if (internal_fd_->non_blocking_ and (errno == EAGAIN or errno == EINPROGRESS)) {
+            return 0;
+        }
+        throw unix_error {"read"};
+    }
+
+    register_read();
+
+    if (bytes_read == 0) {
+        internal_fd_->eof_ = true;
+    }
+
+    if (bytes_read > static_cast<ssize_t>(buffer.size())) {
+        throw runtime_error("read() read more than requested");
+    }
+
+    return bytes_read;
+}
+
 size_t FileDescriptor::write(string_view buffer) {
     return write(vector<string_view> {buffer});
 }
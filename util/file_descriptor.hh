@@ -3,6 +3,7 @@
 #include <cstddef>
 #include <limits>
 #include <memory>
+#include <span>
 #include <vector>
 
 // A reference-counted handle to a file descriptor
@@ -63,6 +64,10 @@ class FileDescriptor {
     void read(std::string& buffer);
     void read(std::vector<std::string>& buffers);
 
+    // Read directly into `buffer` (e.g. the space a ByteStream Writer reserved), without an intermediate string
+    // returns number of bytes read
+    size_t read_into(std::span<char> buffer);
+
     // Attempt to write a buffer
     // returns number of bytes written
     size_t write(std::string_view buffer);
@@ -113,6 +113,17 @@ void IPv4Header::compute_checksum() {
     cksum = check.value();
 }
 
+void IPv4Header::update_checksum(const uint16_t old_word, const uint16_t new_word) {
+    cksum = InternetChecksum::update(cksum, old_word, new_word);
+}
+
+// TTL shares its 16-bit header word with the protocol field
+void IPv4Header::decrement_ttl() {
+    const uint16_t old_word = (static_cast<uint16_t>(ttl) << 8) | proto;
+    ttl--;
+    update_checksum(old_word, (static_cast<uint16_t>(ttl) << 8) | proto);
+}
+
 std::string IPv4Header::to_string() const {
     stringstream ss {};
     ss << hex << boolalpha << "IPv" << +ver << " len=" << dec << +len << " protocol=" << +proto
@@ -56,6 +56,12 @@ struct IPv4Header {
     // Set checksum to correct value
     void compute_checksum();
 
+    // Patch the (already correct) checksum after one 16-bit header word changed, without re-summing the header
+    void update_checksum(uint16_t old_word, uint16_t new_word);
+
+    // Decrement the TTL and patch the checksum to match
+    void decrement_ttl();
+
     // Return a string containing a header in human-readable format
     std::string to_string() const;
 
@@ -0,0 +1,163 @@
+#include "ring_buffer.hh"
+
+#include "exception.hh"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <utility>
+
+using namespace std;
+
+namespace {
+uint64_t page_size() {
+    static const auto size = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+uint64_t round_up_to_pages(const uint64_t size) {
+    return (size + page_size() - 1) / page_size() * page_size();
+}
+} // namespace
+
+//! \param[in] min_size is the minimum number of bytes the ring must hold
+RingBuffer::RingBuffer(const uint64_t min_size) {
+    if (min_size == 0) {
+        return;
+    }
+
+    map(round_up_to_pages(min_size));
+}
+
+RingBuffer::~RingBuffer() {
+    unmap();
+}
+
+// Create the memfd and map it over both halves of a fresh reservation
+void RingBuffer::map(const uint64_t size) {
+    fd_ = CheckSystemCall("memfd_create", memfd_create("ring_buffer", MFD_CLOEXEC));
+    try {
+        CheckSystemCall("ftruncate", ftruncate(fd_, static_cast<off_t>(size)));
+        map_views(size);
+    } catch (...) {
+        ::close(fd_);
+        fd_ = -1;
+        throw;
+    }
+    shift_ = 0;
+}
+
+// Reserve 2 * size bytes of address space, map the first `size` bytes of the memfd over both halves, and only
+// then let go of the old views (the pages live on in the memfd)
+void RingBuffer::map_views(const uint64_t size) {
+    void* const reserved = mmap(nullptr, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (reserved == MAP_FAILED) {
+        throw unix_error {"mmap"};
+    }
+    auto* const base = static_cast<char*>(reserved);
+
+    const bool ok
+      = mmap(base, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd_, 0) != MAP_FAILED
+        and mmap(base + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd_, 0) != MAP_FAILED;
+    if (not ok) {
+        const int saved_errno = errno;
+        munmap(base, 2 * size);
+        throw unix_error {"RingBuffer mmap", saved_errno};
+    }
+
+    if (base_) {
+        munmap(base_, 2 * size_);
+    }
+    base_ = base;
+    size_ = size;
+}
+
+void RingBuffer::unmap() {
+    if (base_) {
+        munmap(base_, 2 * size_);
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+    base_ = nullptr;
+    size_ = 0;
+    shift_ = 0;
+    fd_ = -1;
+}
+
+//! \param[in] min_size is the minimum number of bytes the ring must hold afterwards
+//! \param[in] live_begin is the logical offset of the first byte to keep
+//! \param[in] live_end is the logical offset just past the last byte to keep (at most `size()` after `live_begin`)
+void RingBuffer::grow(const uint64_t min_size, const uint64_t live_begin, const uint64_t live_end) {
+    if (min_size <= size_) {
+        return;
+    }
+    if (size_ == 0) {
+        map(round_up_to_pages(min_size));
+        return;
+    }
+
+    const uint64_t old_size = size_;
+    const uint64_t new_size = round_up_to_pages(min_size);
+    uint64_t first = (live_begin + shift_) % old_size; // memfd offset of the first live byte
+    CheckSystemCall("ftruncate", ftruncate(fd_, static_cast<off_t>(new_size)));
+    map_views(new_size);
+
+    // Live bytes that ran past the end of the old ring went on at its start, and the new pages now lie between
+    // the two sides: move whichever side is shorter (the start side only if the new pages can take it)
+    const uint64_t length = live_end - live_begin;
+    if (first + length > old_size) {
+        const uint64_t head = old_size - first;
+        const uint64_t wrapped = length - head;
+        if (wrapped <= head and wrapped <= new_size - old_size) {
+            memcpy(base_ + old_size, base_, wrapped);
+        } else {
+            memmove(base_ + new_size - head, base_ + first, head);
+            first = new_size - head;
+        }
+    }
+    shift_ = (first + new_size - live_begin % new_size) % new_size;
+}
+
+RingBuffer::RingBuffer(const RingBuffer& other) {
+    if (other.size_) {
+        map(other.size_);
+        memcpy(base_, other.base_, size_);
+        shift_ = other.shift_;
+    }
+}
+
+RingBuffer& RingBuffer::operator=(const RingBuffer& other) {
+    if (this == &other) {
+        return *this;
+    }
+
+    if (size_ != other.size_) {
+        *this = RingBuffer {other};
+        return *this;
+    }
+
+    if (size_) {
+        memcpy(base_, other.base_, size_);
+    }
+    shift_ = other.shift_;
+    return *this;
+}
+
+RingBuffer::RingBuffer(RingBuffer&& other) noexcept
+  : base_(exchange(other.base_, nullptr))
+  , size_(exchange(other.size_, 0))
+  , shift_(exchange(other.shift_, 0))
+  , fd_(exchange(other.fd_, -1)) {}
+
+RingBuffer& RingBuffer::operator=(RingBuffer&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        base_ = exchange(other.base_, nullptr);
+        size_ = exchange(other.size_, 0);
+        shift_ = exchange(other.shift_, 0);
+        fd_ = exchange(other.fd_, -1);
+    }
+    return *this;
+}
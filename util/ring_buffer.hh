@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+//! \brief A byte ring whose storage is mapped twice, back to back, in virtual memory
+//! \details The same [memfd](\ref man2::memfd_create) pages are mapped at `base` and at `base + size()`,
+//! so any `size()`-byte window starting anywhere in the ring can be addressed as one contiguous range.
+//! The size is rounded up to a whole number of pages; a zero-sized RingBuffer maps nothing.
+//!
+//! The ring grows without copying its bytes: it keeps its memfd open, extends it, and maps both halves again
+//! at the larger size in one new reservation, so the bytes stay in their pages and a ring is always one memfd
+//! mapped twice (two VMAs). Only live bytes that wrapped past the end of the old ring must move, since the new
+//! pages go in at that end; the shorter side of the wrap is moved. A mapped ring holds one file descriptor.
+class RingBuffer {
+    char* base_ {};
+    uint64_t size_ {};
+    uint64_t shift_ {}; // where in the ring logical offset 0 lies
+    int fd_ {-1};       // the memfd, kept so that the ring can grow
+
+    void map(uint64_t size);
+    void map_views(uint64_t size);
+    void unmap();
+
+  public:
+    //! Map a ring that holds at least `min_size` bytes
+    explicit RingBuffer(uint64_t min_size);
+    ~RingBuffer();
+
+    //! Usable size of the ring (a multiple of the page size)
+    uint64_t size() const { return size_; }
+
+    //! Address of the byte at logical `offset`; the following `size()` bytes are contiguous
+    char* at(uint64_t offset) { return base_ + (size_ ? (offset + shift_) % size_ : 0); }
+    const char* at(uint64_t offset) const { return base_ + (size_ ? (offset + shift_) % size_ : 0); }
+
+    //! \brief Grow to hold at least `min_size` bytes, keeping the bytes at logical offsets [live_begin, live_end)
+    //! \details The bytes stay where they are, except those that wrapped past the end of the old ring (see
+    //! above); at most half of the live bytes move.
+    void grow(uint64_t min_size, uint64_t live_begin, uint64_t live_end);
+
+    //! Copying duplicates the whole ring into a fresh mapping; moving transfers the mapping
+    RingBuffer(const RingBuffer& other);
+    RingBuffer& operator=(const RingBuffer& other);
+    RingBuffer(RingBuffer&& other) noexcept;
+    RingBuffer& operator=(RingBuffer&& other) noexcept;
+};
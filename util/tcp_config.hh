@@ -1,6 +1,7 @@
 #pragma once
 
 #include "address.hh"
+#include "congestion_control_algorithm.hh"
 #include "wrapping_integers.hh"
 
 #include <cstddef>
@@ -10,15 +11,41 @@
 //! Config for TCP sender and receiver
 class TCPConfig {
   public:
-    static constexpr size_t DEFAULT_CAPACITY = 64000; //!< Default capacity
-    static constexpr size_t MAX_PAYLOAD_SIZE = 1000;  //!< Conservative max payload size for real Internet
-    static constexpr uint16_t TIMEOUT_DFLT = 1000;    //!< Default re-transmit timeout is 1 second
-    static constexpr unsigned MAX_RETX_ATTEMPTS = 8;  //!< Maximum re-transmit attempts before giving up
-
-    uint16_t rt_timeout = TIMEOUT_DFLT;      //!< Initial value of the retransmission timeout, in milliseconds
-    size_t recv_capacity = DEFAULT_CAPACITY; //!< Receive capacity, in bytes
-    size_t send_capacity = DEFAULT_CAPACITY; //!< Sender capacity, in bytes
-    Wrap32 isn {137};                        //!< Default initial sequence number
+    static constexpr size_t DEFAULT_CAPACITY = 64000;   //!< Default capacity
+    static constexpr size_t MAX_PAYLOAD_SIZE = 1000;    //!< Conservative max payload size for real Internet
+    static constexpr uint16_t TIMEOUT_DFLT = 1000;      //!< Default re-transmit timeout is 1 second
+    static constexpr uint16_t TIMEOUT_MIN_DFLT = 200;   //!< Default lower bound of an estimated timeout
+    static constexpr uint16_t TIMEOUT_MAX_DFLT = 60000; //!< Default upper bound of an estimated timeout
+    static constexpr unsigned MAX_RETX_ATTEMPTS = 8;    //!< Maximum re-transmit attempts before giving up
+    static constexpr uint16_t DELAYED_ACK_DFLT = 40;    //!< Default delayed-ACK timeout, in milliseconds
+
+    static constexpr size_t RECV_CAPACITY_DFLT = 16 << 10;    //!< Default receive capacity, where autotuning starts
+    static constexpr size_t RECV_CAPACITY_MAX_DFLT = 4 << 20; //!< Default limit of an autotuned receive capacity
+    static constexpr size_t RECV_BUDGET_DFLT = 64 << 20;      //!< Memory all autotuned receivers may grow into
+    static constexpr size_t SEND_CAPACITY_MAX_DFLT = 4 << 20; //!< Default limit of an autotuned send capacity
+
+    uint16_t rt_timeout = TIMEOUT_DFLT;         //!< Initial value of the retransmission timeout, in milliseconds
+    uint16_t rt_timeout_min = TIMEOUT_MIN_DFLT; //!< Lower bound of the timeout estimated from RTT samples
+    uint16_t rt_timeout_max = TIMEOUT_MAX_DFLT; //!< Upper bound of the timeout estimated from RTT samples
+    size_t recv_capacity = RECV_CAPACITY_DFLT;  //!< Receive capacity, in bytes (initial, if autotuned)
+    size_t send_capacity = DEFAULT_CAPACITY;    //!< Sender capacity, in bytes (initial, if autotuned)
+    uint16_t mss = MAX_PAYLOAD_SIZE;            //!< Largest payload to send or accept per segment
+    Wrap32 isn {137};                           //!< Default initial sequence number
+
+    size_t recv_capacity_max = RECV_CAPACITY_MAX_DFLT; //!< Autotuning grows the receive capacity up to this
+    size_t send_capacity_max = SEND_CAPACITY_MAX_DFLT; //!< Autotuning grows the send capacity up to this
+
+    uint16_t delayed_ack_timeout = DELAYED_ACK_DFLT; //!< Longest an ACK of in-order data waits (0: never delayed)
+    uint16_t delayed_ack_segments = 2;               //!< Full-sized in-order segments acknowledged together
+
+    //! A BBR sender paces even without `pacing`: BBR sets its sending rate through the pace
+    bool pacing = false;      //!< Spread segments over the RTT instead of sending a window in one burst
+    uint64_t pacing_rate = 0; //!< Fixed pacing rate in bytes/s (0: the congestion controller's rate)
+
+    bool fast_open = false; //!< TCP Fast Open: data on the SYN with a cached cookie, accepted with a valid one
+
+    //! Congestion-control algorithm: every TCPPeer runs Reno unless told otherwise (None: receiver's window only)
+    CongestionControl congestion_control = CongestionControl::Reno;
 };
 
 //! Config for classes derived from FdAdapter
@@ -0,0 +1,221 @@
+#pragma once
+
+#include "file_descriptor.hh"
+#include "tcp_config.hh"
+#include "tcp_over_ip.hh"
+#include "tcp_peer.hh"
+#include "tun.hh"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+//! The addresses and ports that name a TCP connection, from our side
+struct FourTuple {
+    uint32_t local_address {};
+    uint32_t remote_address {};
+    uint16_t local_port {};
+    uint16_t remote_port {};
+
+    bool operator==(const FourTuple& other) const = default;
+};
+
+//! \brief A hash table from FourTuples to connection numbers.
+//! \details Open addressing with linear probing over one flat array of slots, so a lookup is a hash and a
+//! short scan of adjacent slots. Erasing shifts the following entries back instead of leaving tombstones, so
+//! probe sequences stay short however many connections come and go.
+class ConnectionTable {
+  public:
+    //! Size the table for `expected_connections` without growing
+    explicit ConnectionTable(size_t expected_connections = 0);
+
+    //! Add an entry; returns false (and changes nothing) if the 4-tuple is already there
+    bool insert(const FourTuple& key, uint32_t connection);
+
+    //! The connection the 4-tuple names, if any
+    std::optional<uint32_t> find(const FourTuple& key) const;
+
+    //! Remove an entry; returns false if the 4-tuple was not there
+    bool erase(const FourTuple& key);
+
+    size_t size() const { return size_; }
+
+    //! Bytes used by the slots
+    size_t memory_usage() const { return slots_.capacity() * sizeof(Slot); }
+
+  private:
+    static constexpr uint32_t EMPTY = UINT32_MAX; //!< connection number of a free slot
+    static constexpr size_t MIN_SLOTS = 16;
+
+    struct Slot {
+        FourTuple key {};
+        uint32_t connection = EMPTY;
+    };
+
+    //! The slot where a probe for `key` starts
+    size_t home(const FourTuple& key) const;
+
+    //! The slot holding `key`, if any
+    std::optional<size_t> locate(const FourTuple& key) const;
+
+    //! Double the slots and re-insert every entry
+    void grow();
+
+    std::vector<Slot> slots_;
+    size_t size_ {};
+    uint64_t seed_; //!< random, so that peers cannot choose 4-tuples that collide
+};
+
+//! Config for a listener of TCPOverIPv4Demultiplexer
+class ListenerConfig {
+  public:
+    static constexpr size_t BACKLOG_DFLT = 128;     //!< Default length of the accept queue
+    static constexpr size_t SYN_BACKLOG_DFLT = 256; //!< Default length of the SYN queue
+
+    Address local {"0", 0};                //!< Address (0: any) and port to accept connections on
+    size_t backlog = BACKLOG_DFLT;         //!< Connections whose handshake completed, waiting for accept()
+    size_t syn_backlog = SYN_BACKLOG_DFLT; //!< Half-open connections, waiting for the peer's ACK
+    bool syn_cookies = false;              //!< Once the SYN queue is full, answer SYNs without keeping state
+};
+
+//! \brief Many TCP connections over a single TUN device.
+//! \details One reader takes each datagram from the device, reads only its 4-tuple, and looks up the connection
+//! in a ConnectionTable; only that connection's adapter parses the rest. Each connection keeps its own
+//! TCPOverIPv4Adapter (addresses and negotiated options) and TCPPeer.
+//!
+//! A listener takes the datagrams that name no connection but are addressed to its port. Each SYN opens a
+//! half-open connection in its bounded SYN queue; once the handshake completes, the connection moves to the
+//! accept queue, where accept() hands it out. With SYN cookies, a SYN that finds the SYN queue full is answered
+//! with a SYN-ACK whose sequence number encodes the connection, and the connection is only created when the
+//! peer's ACK returns it. With Fast Open (TCPConfig::fast_open), a listener issues cookies, and a connection
+//! whose SYN returns a valid one joins the accept queue with its data at once. Any other datagram that names no
+//! connection is dropped.
+//!
+//! An idle connection costs its TCPPeer and adapter, a few KB. A stream maps its ring (two mappings, and the
+//! memfd's file descriptor) only once it carries data, so the number of connections whose streams all carry
+//! data at once is bounded by the file-descriptor limit (RLIMIT_NOFILE, two per connection) and by
+//! vm.max_map_count (about 16,000 connections at the default of 65530). The demultiplexer runs in its caller's
+//! thread and event loop; TCPMinnowSocket and the apps still give each connection its own device and thread.
+class TCPOverIPv4Demultiplexer {
+  public:
+    //! Construct from a TunFD, bounding segments by its MTU (and trusting the checksums it vouches for, if it
+    //! was opened with checksum offload)
+    explicit TCPOverIPv4Demultiplexer(TunFD&& tun, size_t expected_connections = 0);
+
+    //! Construct from any file descriptor that carries one IPv4 datagram per read and write
+    TCPOverIPv4Demultiplexer(FileDescriptor&& fd, size_t mtu, size_t expected_connections = 0);
+
+    //! Open a connection from `adapter_config.source` to `adapter_config.destination` and send its SYN
+    //! \details With `tcp_config.fast_open` and a cookie cached for the destination, `first_data` rides on the
+    //! SYN; otherwise it is sent once the handshake completes.
+    //! \returns the connection number
+    size_t connect(const TCPConfig& tcp_config, const FdAdapterConfig& adapter_config, std::string first_data = {});
+
+    //! \name
+    //! Access a connection by number; the references stay valid until the connection is erased
+
+    //!@{
+    TCPPeer& peer(size_t connection) { return at(connection).peer; }
+    const FdAdapterConfig& config(size_t connection) const { return at(connection).adapter.config(); }
+    //!@}
+
+    //! Send what the connection's outbound stream holds, as far as its windows allow
+    void push(size_t connection);
+
+    //! Forget a connection (e.g. once its peer is no longer active); its number may be reused
+    void erase(size_t connection);
+
+    //! Accept connections to `listener_config.local`, each with a TCPPeer configured by `tcp_config`
+    //! \returns the listener number
+    size_t listen(const TCPConfig& tcp_config, const ListenerConfig& listener_config);
+
+    //! The next connection to the listener whose handshake has completed, if any
+    std::optional<size_t> accept(size_t listener);
+
+    //! Read one datagram from the device and hand it to its connection
+    //! \returns the connection number, if the datagram named one
+    std::optional<size_t> read();
+
+    //! Hand a serialized IPv4 datagram to its connection (`checksum_verified`: see unwrap_tcp_in_ip)
+    //! \returns the connection number, if the datagram named one
+    std::optional<size_t> receive(const std::vector<std::string>& datagram, bool checksum_verified = false);
+
+    //! Advance every connection's clock, and give up on half-open connections whose SYN-ACK went unanswered
+    void tick(uint64_t ms_since_last_tick);
+
+    //! Number of open connections
+    size_t size() const { return table_.size(); }
+
+    //! Access the underlying file descriptor
+    FileDescriptor& fd() { return fd_; }
+
+    //! The 4-tuple of a serialized IPv4 datagram carrying TCP, as seen by its receiver (so the local address is
+    //! the datagram's destination). Reads only the addresses, protocol and ports.
+    static std::optional<FourTuple> four_tuple(const std::vector<std::string>& datagram);
+
+  private:
+    static constexpr uint64_t SYN_ACK_RETRIES = 5;      //!< Retransmissions before a half-open one is dropped
+    static constexpr uint64_t COOKIE_PERIOD_MS = 64000; //!< A SYN cookie is valid for one to two periods
+    static constexpr std::array<uint16_t, 4> COOKIE_MSS {536, 1300, 1440, 1460}; //!< MSS a cookie encodes
+
+    struct Connection {
+        explicit Connection(const TCPConfig& tcp_config) : peer(tcp_config) {}
+
+        TCPOverIPv4Adapter adapter {};
+        TCPPeer peer;
+        std::optional<size_t> listener {}; //!< the listener it came from, until accept() hands it out
+        bool established {};               //!< in the accept queue: the handshake completed, or Fast Open data came
+    };
+
+    struct Listener {
+        TCPConfig tcp_config;
+        ListenerConfig config;
+        size_t half_open {};                  //!< connections in the SYN queue
+        std::deque<uint32_t> accept_queue {}; //!< established connections, in order of completion
+    };
+
+    static FourTuple four_tuple(const FdAdapterConfig& adapter_config);
+
+    Connection& at(size_t connection);
+    const Connection& at(size_t connection) const;
+
+    //! Add a connection with the given adapter configuration and an unused number
+    size_t open(const TCPConfig& tcp_config, const FdAdapterConfig& adapter_config);
+
+    //! Offer a datagram that names no connection to the listener on its port
+    //! \returns the number of the connection it opened, if any
+    std::optional<size_t> listener_receive(const FourTuple& key,
+                                           const std::vector<std::string>& datagram,
+                                           bool checksum_verified);
+
+    //! Move a half-open connection to its listener's accept queue once its handshake completes (or, with Fast
+    //! Open, once the data on its SYN is accepted)
+    void check_established(size_t connection);
+
+    //! The sequence number of a SYN-ACK that answers `client_isn` statelessly, encoding `mss` and the time
+    uint32_t syn_cookie(const FourTuple& key, uint32_t client_isn, uint16_t mss, uint64_t period) const;
+
+    //! The MSS a cookie returned in an ACK encodes, if it is one we issued recently
+    std::optional<uint16_t> check_syn_cookie(const FourTuple& key, uint32_t client_isn, uint32_t cookie) const;
+
+    //! Wrap a segment of `connection` and write it to the device
+    void write(Connection& connection, const TCPMessage& msg);
+
+    size_t mtu_;
+    bool checksum_offload_ {}; //!< the device frames datagrams with a virtio_net_hdr (TunTapFD::checksum_offload)
+    FileDescriptor fd_;
+    ConnectionTable table_;
+    std::vector<std::unique_ptr<Connection>> connections_ {}; //!< indexed by connection number
+    std::vector<uint32_t> free_numbers_ {};                    //!< numbers of erased connections
+    std::vector<Listener> listeners_ {};                       //!< indexed by listener number
+
+    uint64_t now_ms_ {};
+    std::default_random_engine rng_; //!< initial sequence numbers of accepted connections
+    uint64_t cookie_secret_;         //!< keys the SYN cookie hash
+};
@@ -125,6 +125,7 @@ class CS144TCPSocket : public TCPOverIPv4MinnowSocket {
     void connect(const Address& address) {
         TCPConfig tcp_config;
         tcp_config.rt_timeout = 100;
+        tcp_config.rt_timeout_min = 10; // the lab's links have RTTs of a few ms
 
         FdAdapterConfig multiplexer_config;
         multiplexer_config.source = {"169.254.144.9", std::to_string(uint16_t(std::random_device()()))};
@@ -1,37 +1,146 @@
 #include "tcp_over_ip.hh"
 
+#include "checksum.hh"
 #include "ipv4_datagram.hh"
 #include "ipv4_header.hh"
 #include "parser.hh"
 
+#include <algorithm>
+#include <array>
 #include <arpa/inet.h>
+#include <mutex>
+#include <random>
 #include <stdexcept>
 #include <unistd.h>
+#include <unordered_map>
 #include <utility>
 
 using namespace std;
 
-//! \details This function attempts to parse a TCP segment from
-//! the IP datagram's payload.
-//!
-//! If this succeeds, it then checks that the received segment is related to the
-//! current connection. When a TCP connection has been established, this means
-//! checking that the source and destination ports in the TCP header are correct.
+namespace {
+// The server's secret and the client's cache. The cache may be shared by TCPMinnowSocket threads.
+struct FastOpenState {
+    uint64_t secret = (uint64_t {random_device()()} << 32) | random_device()();
+    mutex cache_mutex {};
+    unordered_map<uint32_t, string> cache {};
+};
+
+FastOpenState& fast_open_state() {
+    static FastOpenState state;
+    return state;
+}
+
+// Where the header template is patched for each segment
+constexpr size_t IPLengthOffset = 2;
+constexpr size_t IPChecksumOffset = 10;
+constexpr size_t TCPSeqnoOffset = 4; // followed by the ackno, data offset and flags, and window
+constexpr size_t TCPChecksumOffset = 16;
+
+// Only SYNs (MSS, window scale, SACK-permitted, Fast Open) and ACKs with SACK blocks carry TCP options
+bool has_options(const TCPMessage& msg) {
+    return msg.sender.SYN or msg.sender.SACK_permitted or not msg.receiver.sack_blocks.empty();
+}
+
+// The source and destination ports at the start of a TCP header, wherever the buffer boundaries fall
+optional<pair<uint16_t, uint16_t>> peek_ports(const vector<string>& buffers) {
+    array<uint8_t, 4> bytes {};
+    size_t gathered = 0;
+    for (const auto& buffer : buffers) {
+        for (size_t i = 0; i < buffer.size() and gathered < bytes.size(); ++i) {
+            bytes.at(gathered++) = static_cast<uint8_t>(buffer[i]);
+        }
+    }
+    if (gathered < bytes.size()) {
+        return {};
+    }
+    return pair {static_cast<uint16_t>(bytes[0] << 8 | bytes[1]), static_cast<uint16_t>(bytes[2] << 8 | bytes[3])};
+}
+
+string concatenate(const vector<string>& buffers) {
+    string ret;
+    for (const auto& buffer : buffers) {
+        ret += buffer;
+    }
+    return ret;
+}
+
+void put_word(string& buffer, size_t offset, uint16_t word) {
+    buffer[offset] = static_cast<char>(word >> 8);
+    buffer[offset + 1] = static_cast<char>(word);
+}
+
+uint16_t get_word(const string& buffer, size_t offset) {
+    const auto byte = [&](size_t i) { return static_cast<uint8_t>(buffer[i]); };
+    return static_cast<uint16_t>(byte(offset) << 8 | byte(offset + 1));
+}
+
+class Wrap32Raw : public Wrap32 {
+  public:
+    uint32_t raw_value() const { return raw_value_; }
+};
+
+uint32_t raw(Wrap32 seqno) {
+    return Wrap32Raw {seqno}.raw_value();
+}
+} // namespace
+
+string FastOpenCookies::issue(uint32_t client_address) {
+    // an 8-byte keyed hash (SipHash-like mixing), so a cookie is only valid for the address it was issued to
+    uint64_t x = fast_open_state().secret ^ (uint64_t {client_address} * 0x9e3779b97f4a7c15);
+    for (int round = 0; round < 2; ++round) {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccd;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53;
+        x ^= x >> 33;
+    }
+    string cookie(sizeof(x), 0);
+    for (auto& c : cookie) {
+        c = static_cast<char>(x);
+        x >>= 8;
+    }
+    return cookie;
+}
+
+optional<string> FastOpenCookies::cached(uint32_t server_address) {
+    auto& state = fast_open_state();
+    const lock_guard lock {state.cache_mutex};
+    const auto it = state.cache.find(server_address);
+    if (it == state.cache.end()) {
+        return {};
+    }
+    return it->second;
+}
+
+void FastOpenCookies::cache(uint32_t server_address, string cookie) {
+    auto& state = fast_open_state();
+    const lock_guard lock {state.cache_mutex};
+    state.cache.insert_or_assign(server_address, move(cookie));
+}
+
+//! \details This function first checks that the datagram is related to the current
+//! connection, from its addresses and the ports at the start of the TCP header, so an
+//! unrelated datagram costs neither a checksum nor a copy of its payload. It then
+//! parses the TCP segment from the IP datagram's payload, verifying its checksum
+//! unless `checksum_verified`.
 //!
 //! If the TCP connection is listening (i.e., TCPOverIPv4OverTunFdAdapter::_listen is `true`)
 //! and the TCP segment read from the wire includes a SYN, this function clears the
 //! `_listen` flag and records the source and destination addresses and port numbers
 //! from the TCP header; it uses this information to filter future reads.
 //! \returns a std::optional<TCPSegment> that is empty if the segment was invalid or unrelated
-optional<TCPMessage> TCPOverIPv4Adapter::unwrap_tcp_in_ip(const InternetDatagram& ip_dgram) {
+optional<TCPMessage> TCPOverIPv4Adapter::unwrap_tcp_in_ip(const InternetDatagram& ip_dgram,
+                                                          bool checksum_verified) {
+    const auto& headers = header_template();
+
     // is the IPv4 datagram for us?
     // Note: it's valid to bind to address "0" (INADDR_ANY) and reply from actual address contacted
-    if (not listening() and (ip_dgram.header.dst != config().source.ipv4_numeric())) {
+    if (not listening() and (ip_dgram.header.dst != headers.ip_header.src)) {
         return {};
     }
 
     // is the IPv4 datagram from our peer?
-    if (not listening() and (ip_dgram.header.src != config().destination.ipv4_numeric())) {
+    if (not listening() and (ip_dgram.header.src != headers.ip_header.dst)) {
         return {};
     }
 
@@ -40,14 +149,18 @@ optional<TCPMessage> TCPOverIPv4Adapter::unwrap_tcp_in_ip(const InternetDatagram
         return {};
     }
 
-    // is the payload a valid TCP segment?
-    TCPSegment tcp_seg;
-    if (not parse(tcp_seg, ip_dgram.payload, ip_dgram.header.pseudo_checksum())) {
+    // is the TCP segment for us, and from our peer? Only its ports are read so far
+    const auto ports = peek_ports(ip_dgram.payload);
+    if (not ports.has_value() or ports->second != get_word(headers.serialized, IPv4Header::LENGTH)) {
+        return {};
+    }
+    if (not listening() and ports->first != get_word(headers.serialized, IPv4Header::LENGTH + 2)) {
         return {};
     }
 
-    // is the TCP segment for us?
-    if (tcp_seg.udinfo.dst_port != config().source.port()) {
+    // is the payload a valid TCP segment?
+    TCPSegment tcp_seg;
+    if (not parse(tcp_seg, ip_dgram.payload, ip_dgram.header.pseudo_checksum(), not checksum_verified)) {
         return {};
     }
 
@@ -63,9 +176,35 @@ optional<TCPMessage> TCPOverIPv4Adapter::unwrap_tcp_in_ip(const InternetDatagram
         }
     }
 
-    // is the TCP segment from our peer?
-    if (tcp_seg.udinfo.src_port != config().destination.port()) {
-        return {};
+    // data on the peer's SYN counts only with the Fast Open cookie we issued to its address; otherwise (as a Fast
+    // Open server, or for any SYN with a cookie) it is dropped here, and the peer resends it after the handshake.
+    // A SYN-ACK brings the cookie to use on our next connection.
+    auto& sender = tcp_seg.message.sender;
+    if (sender.SYN and not tcp_seg.message.receiver.ackno.has_value()) {
+        const auto valid_cookie = FastOpenCookies::issue(ip_dgram.header.src);
+        if ((fast_open_ or sender.fast_open_cookie.has_value())
+            and (not fast_open_ or sender.fast_open_cookie != valid_cookie)) {
+            sender.payload.clear();
+            sender.FIN = false;
+            if (fast_open_ and sender.fast_open_cookie.has_value()) {
+                fast_open_cookie_ = valid_cookie;
+            }
+        }
+    } else if (sender.SYN and sender.fast_open_cookie.has_value() and not sender.fast_open_cookie->empty()) {
+        FastOpenCookies::cache(ip_dgram.header.src, sender.fast_open_cookie.value());
+    }
+    sender.fast_open_cookie.reset();
+
+    // the peer's MSS comes with its SYN, bounded by our MTU. The window in a SYN is never scaled; later ones
+    // are if both SYNs carried the window-scale option
+    auto& receiver = tcp_seg.message.receiver;
+    if (tcp_seg.message.sender.SYN) {
+        receiver.max_segment_size = min(receiver.max_segment_size.value_or(DEFAULT_MSS), max_segment_size());
+        peer_syn_seen_ = true;
+        peer_window_scale_ = receiver.window_scale;
+        receiver.window_scale.reset();
+    } else {
+        receiver.window_scale = window_scaling() ? peer_window_scale_ : nullopt;
     }
 
     return tcp_seg.message;
@@ -74,21 +213,132 @@ optional<TCPMessage> TCPOverIPv4Adapter::unwrap_tcp_in_ip(const InternetDatagram
 //! Takes a TCP segment, sets port numbers as necessary, and wraps it in an IPv4 datagram
 //! \param[in] seg is the TCP segment to convert
 InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip(const TCPMessage& msg) {
+    if (has_options(msg)) {
+        return wrap_with_options(msg);
+    }
+
+    const auto headers = patched_headers(msg);
+    InternetDatagram ip_dgram {.header = header_template().ip_header};
+    ip_dgram.header.len = get_word(headers, IPLengthOffset);
+    ip_dgram.header.cksum = get_word(headers, IPChecksumOffset);
+    ip_dgram.payload.push_back(headers.substr(IPv4Header::LENGTH));
+    if (not msg.sender.payload.empty()) {
+        ip_dgram.payload.push_back(msg.sender.payload);
+    }
+    return ip_dgram;
+}
+
+vector<string> TCPOverIPv4Adapter::serialize_tcp_in_ip(const TCPMessage& msg) {
+    if (has_options(msg)) {
+        return serialize(wrap_with_options(msg));
+    }
+
+    vector<string> datagram {patched_headers(msg)};
+    if (not msg.sender.payload.empty()) {
+        datagram.push_back(msg.sender.payload);
+    }
+    return datagram;
+}
+
+uint16_t TCPOverIPv4Adapter::window_size(const TCPMessage& msg) const {
+    // send the window unscaled until both sides have offered window scaling
+    if (msg.sender.SYN or not window_scaling()) {
+        const uint64_t window = uint64_t {msg.receiver.window_size} << msg.receiver.window_scale.value_or(0);
+        return static_cast<uint16_t>(min<uint64_t>(window, UINT16_MAX));
+    }
+    return msg.receiver.window_size;
+}
+
+string TCPOverIPv4Adapter::patched_headers(const TCPMessage& msg) {
+    const auto& headers = header_template();
+    const auto& payload = msg.sender.payload;
+    const auto tcp_length = static_cast<uint16_t>(TCPSegment::MIN_HEADER_LENGTH + payload.size());
+    const auto total_length = static_cast<uint16_t>(IPv4Header::LENGTH + tcp_length);
+
+    string ret = headers.serialized;
+    put_word(ret, IPLengthOffset, total_length);
+    put_word(ret, IPChecksumOffset, InternetChecksum::update(headers.ip_header.cksum, 0, total_length));
+
+    // patch the fields that change into the TCP header, adding each 16-bit word to the checksum
+    const uint32_t seqno = raw(msg.sender.seqno);
+    const uint32_t ackno = raw(msg.receiver.ackno.value_or(Wrap32 {0}));
+    const bool reset = msg.sender.RST or msg.receiver.RST;
+    const uint16_t offset_and_flags = (TCPSegment::MIN_HEADER_LENGTH / 4 << 12)
+                                      | (msg.receiver.ackno.has_value() ? 0b0001'0000U : 0)
+                                      | (reset ? 0b0000'0100U : 0) | (msg.sender.FIN ? 0b0000'0001U : 0);
+    const array<uint16_t, 6> words {static_cast<uint16_t>(seqno >> 16),
+                                    static_cast<uint16_t>(seqno),
+                                    static_cast<uint16_t>(ackno >> 16),
+                                    static_cast<uint16_t>(ackno),
+                                    offset_and_flags,
+                                    window_size(msg)};
+    uint32_t sum = headers.tcp_sum + tcp_length;
+    for (size_t i = 0; i < words.size(); ++i) {
+        put_word(ret, IPv4Header::LENGTH + TCPSeqnoOffset + 2 * i, words[i]);
+        sum += words[i];
+    }
+
+    InternetChecksum check {sum};
+    check.add(payload);
+    put_word(ret, IPv4Header::LENGTH + TCPChecksumOffset, check.value());
+    return ret;
+}
+
+InternetDatagram TCPOverIPv4Adapter::wrap_with_options(const TCPMessage& msg) {
+    const auto& headers = header_template();
     TCPSegment seg {.message = msg};
-    // set the port numbers in the TCP segment
-    seg.udinfo.src_port = config().source.port();
-    seg.udinfo.dst_port = config().destination.port();
+    seg.udinfo.src_port = get_word(headers.serialized, IPv4Header::LENGTH);
+    seg.udinfo.dst_port = get_word(headers.serialized, IPv4Header::LENGTH + 2);
 
-    // create an Internet Datagram and set its addresses and length
-    InternetDatagram ip_dgram;
-    ip_dgram.header.src = config().source.ipv4_numeric();
-    ip_dgram.header.dst = config().destination.ipv4_numeric();
-    ip_dgram.header.len = ip_dgram.header.hlen * 4 + 20 /* tcp header len */ + seg.message.sender.payload.size();
+    // advertise an MSS that fits our MTU and offer window scaling on our SYN (on a SYN-ACK, only if the peer's
+    // SYN offered it too)
+    auto& receiver = seg.message.receiver;
+    receiver.window_size = window_size(msg);
+    if (seg.message.sender.SYN) {
+        receiver.max_segment_size = min(receiver.max_segment_size.value_or(UINT16_MAX), max_segment_size());
+        if (peer_syn_seen_ and not peer_window_scale_.has_value()) {
+            receiver.window_scale.reset();
+        }
+        window_scale_sent_ |= receiver.window_scale.has_value();
+        if (fast_open_cookie_.has_value()) {
+            seg.message.sender.fast_open_cookie = fast_open_cookie_;
+        }
+    }
 
-    // set payload, calculating TCP checksum using information from IP header
-    seg.compute_checksum(ip_dgram.header.pseudo_checksum());
+    InternetDatagram ip_dgram {.header = headers.ip_header};
+    ip_dgram.header.len = ip_dgram.header.hlen * 4 + seg.header_length() + seg.message.sender.payload.size();
     ip_dgram.header.compute_checksum();
-    ip_dgram.payload = serialize(seg);
 
+    seg.compute_checksum(ip_dgram.header.pseudo_checksum());
+    ip_dgram.payload = serialize(seg);
     return ip_dgram;
 }
+
+const TCPOverIPv4Adapter::HeaderTemplate& TCPOverIPv4Adapter::header_template() {
+    if (header_template_.has_value() and header_template_->source == config().source
+        and header_template_->destination == config().destination) {
+        return header_template_.value();
+    }
+
+    HeaderTemplate headers {.source = config().source, .destination = config().destination};
+    headers.ip_header.src = config().source.ipv4_numeric();
+    headers.ip_header.dst = config().destination.ipv4_numeric();
+    headers.ip_header.compute_checksum();
+
+    TCPSegment tcp_segment;
+    tcp_segment.udinfo.src_port = config().source.port();
+    tcp_segment.udinfo.dst_port = config().destination.port();
+    headers.serialized = concatenate(serialize(headers.ip_header)) + concatenate(serialize(tcp_segment));
+    put_word(headers.serialized, IPv4Header::LENGTH + TCPChecksumOffset, 0); // only summed once patched
+
+    IPv4Header pseudo_header = headers.ip_header;
+    pseudo_header.len = IPv4Header::LENGTH; // no payload: each segment adds its own length
+    headers.tcp_sum = pseudo_header.pseudo_checksum() + tcp_segment.udinfo.src_port + tcp_segment.udinfo.dst_port;
+
+    return header_template_.emplace(move(headers));
+}
+
+uint16_t TCPOverIPv4Adapter::max_segment_size() const {
+    constexpr size_t headers = IPv4Header::LENGTH + TCPSegment::MIN_HEADER_LENGTH;
+    return static_cast<uint16_t>(min<size_t>(mtu_ > headers ? mtu_ - headers : 0, UINT16_MAX));
+}
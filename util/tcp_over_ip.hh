@@ -1,15 +1,92 @@
 #pragma once
 
+#include "address.hh"
 #include "fd_adapter.hh"
 #include "ipv4_datagram.hh"
 #include "tcp_segment.hh"
 
+#include <cstddef>
+#include <cstdint>
 #include <optional>
+#include <string>
+#include <vector>
+
+//! \brief TCP Fast Open (RFC 7413) cookies, shared by every connection in the process.
+//! \details A server issues each client address a cookie, a keyed hash of the address, which it can check later
+//! without keeping state. A client caches the cookie of each server address for its next connections.
+class FastOpenCookies {
+  public:
+    //! The cookie for a client at `client_address`
+    static std::string issue(uint32_t client_address);
+
+    //! The cookie cached for the server at `server_address`, if any
+    static std::optional<std::string> cached(uint32_t server_address);
+
+    //! Remember the cookie the server at `server_address` issued
+    static void cache(uint32_t server_address, std::string cookie);
+};
 
 //! \brief A converter from TCP segments to serialized IPv4 datagrams
 class TCPOverIPv4Adapter : public FdAdapterBase {
   public:
-    std::optional<TCPMessage> unwrap_tcp_in_ip(const InternetDatagram& ip_dgram);
+    //! Datagrams for other connections are rejected from their addresses and ports, before any payload work.
+    //! With `checksum_verified` (the device verified the TCP checksum, as with checksum offload), the payload is
+    //! not summed again.
+    std::optional<TCPMessage> unwrap_tcp_in_ip(const InternetDatagram& ip_dgram, bool checksum_verified = false);
 
+    //! Segments without TCP options (all but SYNs and ACKs with SACK blocks) are copied from a header template
+    //! and patched, with their checksums completed from precomputed partial sums
     InternetDatagram wrap_tcp_in_ip(const TCPMessage& msg);
+
+    //! Wrap a segment and serialize the datagram in one step: the template's IPv4 and TCP headers, patched, in
+    //! one buffer, then the payload
+    std::vector<std::string> serialize_tcp_in_ip(const TCPMessage& msg);
+
+    //! Set the MTU of the underlying interface, which bounds the segment size in both directions
+    void set_mtu(size_t mtu) { mtu_ = mtu; }
+
+    //! As a server, issue Fast Open cookies to clients that ask, and accept data only on SYNs that return a valid
+    //! one. Either way, data on a SYN that is not accepted is dropped; the client resends it after the handshake.
+    void set_fast_open(bool fast_open) { fast_open_ = fast_open; }
+
+  private:
+    static constexpr size_t DEFAULT_MTU = 1500;  //!< Ethernet
+    static constexpr uint16_t DEFAULT_MSS = 536; //!< Assumed if the peer's SYN has no MSS option (RFC 9293)
+
+    //! The largest TCP payload that fits in one datagram, without IP or TCP options
+    uint16_t max_segment_size() const;
+    size_t mtu_ = DEFAULT_MTU; //!< MTU of the underlying interface
+
+    //! Window scaling (RFC 7323) is in effect once both SYNs carried the option
+    bool window_scaling() const { return window_scale_sent_ and peer_window_scale_.has_value(); }
+    bool window_scale_sent_ = false;              //!< Did our SYN carry the window-scale option?
+    bool peer_syn_seen_ = false;                  //!< Has the peer's SYN arrived?
+    std::optional<uint8_t> peer_window_scale_ {}; //!< The shift the peer applies to its windows
+
+    bool fast_open_ = false;                         //!< Accept data on SYNs with a valid cookie?
+    std::optional<std::string> fast_open_cookie_ {}; //!< The cookie to send on our SYN-ACK, if the peer needs one
+
+    //! Our window, unscaled unless window scaling is in effect
+    uint16_t window_size(const TCPMessage& msg) const;
+
+    //! \brief The headers that only depend on the connection's addresses and ports, serialized once
+    //! \details The IPv4 header has length 0 and the matching checksum; the TCP header has the ports, and
+    //! `tcp_sum` is the unfolded sum of the ports and the pseudo-header without its length.
+    struct HeaderTemplate {
+        Address source;
+        Address destination;
+        IPv4Header ip_header {};
+        std::string serialized {}; //!< the IPv4 header, then the TCP header
+        uint32_t tcp_sum {};
+    };
+
+    //! The template for the current config(), rebuilt when its addresses change
+    const HeaderTemplate& header_template();
+    std::optional<HeaderTemplate> header_template_ {};
+
+    //! The serialized headers of a segment without options
+    std::string patched_headers(const TCPMessage& msg);
+
+    //! Build a datagram field by field, for segments that carry options
+    InternetDatagram wrap_with_options(const TCPMessage& msg);
 };
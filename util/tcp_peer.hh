@@ -7,8 +7,10 @@
 #include "tcp_sender.hh"
 #include "tcp_sender_message.hh"
 
+#include <algorithm>
 #include <functional>
 #include <optional>
+#include <string>
 
 class TCPPeer {
     auto make_send(const auto& transmit) {
@@ -16,7 +18,21 @@ class TCPPeer {
     }
 
   public:
-    explicit TCPPeer(const TCPConfig& cfg) : cfg_(cfg) {}
+    explicit TCPPeer(const TCPConfig& cfg) : cfg_(cfg) {
+        if (cfg_.recv_capacity_max > cfg_.recv_capacity) {
+            receiver_.enable_autotuning(cfg_.recv_capacity_max);
+        }
+        if (cfg_.send_capacity_max > cfg_.send_capacity) {
+            sender_.enable_autotuning(cfg_.send_capacity_max);
+        }
+        if (cfg_.pacing) {
+            const auto rate = static_cast<double>(cfg_.pacing_rate) / 1000;
+            sender_.enable_pacing(cfg_.pacing_rate > 0 ? std::optional<double> {rate} : std::nullopt);
+        }
+    }
+
+    /* Fast Open, before the first push: see TCPSender::enable_fast_open */
+    void enable_fast_open(std::optional<std::string> cookie) { sender_.enable_fast_open(std::move(cookie)); }
 
     Writer& outbound_writer() { return sender_.writer(); }
     Reader& inbound_reader() { return receiver_.reader(); }
@@ -28,7 +44,11 @@ class TCPPeer {
     void push(const TransmitFunction& transmit) { sender_.push(make_send(transmit)); }
     void tick(uint64_t t, const TransmitFunction& transmit) {
         cumulative_time_ += t;
+        receiver_.tick(t);
         sender_.tick(t, make_send(transmit));
+        if (ack_deadline_.has_value() and cumulative_time_ >= ack_deadline_.value()) {
+            send(sender_.make_empty_message(), transmit);
+        }
     }
     bool has_ackno() const { return receiver_.send().ackno.has_value(); }
 
@@ -51,14 +71,21 @@ class TCPPeer {
         // Record time in case this peer has to linger after streams finish.
         time_of_last_receipt_ = cumulative_time_;
 
-        // If SenderMessage occupies a sequence number, make sure to reply.
-        need_send_ |= (msg.sender.sequence_length() > 0);
-
         // If SenderMessage is a "keep-alive" (with intentionally invalid seqno), make sure to reply.
         // (N.B. orthodox TCP rules require a reply on any unacceptable segment.)
         const auto our_ackno = receiver_.send().ackno;
         need_send_ |= (our_ackno.has_value() and msg.sender.seqno + 1 == our_ackno.value());
 
+        // If SenderMessage occupies a sequence number, make sure to reply. Only plain data that arrives in
+        // order, with no hole behind it, may wait for a second segment or the delayed-ACK timeout
+        // (RFC 1122 4.2.3.2, RFC 5681 4.2); SYN, FIN and out-of-order data are acknowledged at once.
+        const bool occupies_seqnos = msg.sender.sequence_length() > 0;
+        const uint64_t payload_size = msg.sender.payload.size();
+        const bool delayable = cfg_.delayed_ack_timeout > 0 and occupies_seqnos and not msg.sender.SYN
+                               and not msg.sender.FIN and our_ackno.has_value()
+                               and msg.sender.seqno == our_ackno.value()
+                               and receiver_.reassembler().bytes_pending() == 0;
+
         // Did the inbound stream finish before the outbound stream? If so, no need to linger after streams finish.
         if (receiver_.writer().is_closed() and not sender_.reader().is_finished()) {
             linger_after_streams_finish_ = false;
@@ -67,6 +94,13 @@ class TCPPeer {
         // Give incoming TCPSenderMessage to receiver.
         receiver_.receive(std::move(msg.sender));
 
+        // Segments the receiver could not take (e.g. probes of a closed window) are answered at once.
+        if (delayable and receiver_.send().ackno != our_ackno) {
+            delay_ack(payload_size);
+        } else {
+            need_send_ |= occupies_seqnos;
+        }
+
         // Give incoming TCPReceiverMessage to sender.
         sender_.receive(msg.receiver);
 
@@ -83,15 +117,40 @@ class TCPPeer {
 
   private:
     TCPConfig cfg_;
-    TCPSender sender_ {ByteStream {cfg_.send_capacity}, cfg_.isn, cfg_.rt_timeout};
-    TCPReceiver receiver_ {Reassembler {ByteStream {cfg_.recv_capacity}}};
+    TCPSender sender_ {ByteStream {cfg_.send_capacity},
+                       cfg_.isn,
+                       cfg_.rt_timeout,
+                       TCPSender::RTOBounds {cfg_.rt_timeout_min, cfg_.rt_timeout_max},
+                       make_congestion_controller(cfg_.congestion_control, cfg_.mss),
+                       cfg_.mss};
+    TCPReceiver receiver_ {Reassembler {ByteStream {cfg_.recv_capacity}}, cfg_.mss};
 
     bool need_send_ {};
 
+    /* delayed ACK: full-sized in-order segments not yet acknowledged, and when the ACK is due at the latest.
+       A segment as large as the largest the peer has sent counts as full-sized; smaller ones wait for the timer
+       or a full-sized one (RFC 1122 4.2.3.2: an ACK for at least every second full-sized segment). */
+    uint64_t segments_unacked_ {};
+    uint64_t largest_payload_ {};
+    std::optional<uint64_t> ack_deadline_ {};
+
+    void delay_ack(uint64_t payload_size) {
+        largest_payload_ = std::max(largest_payload_, payload_size);
+        const bool full_sized = payload_size == largest_payload_;
+        if (full_sized and ++segments_unacked_ >= cfg_.delayed_ack_segments) {
+            need_send_ = true;
+        } else if (not ack_deadline_.has_value()) {
+            ack_deadline_ = cumulative_time_ + cfg_.delayed_ack_timeout;
+        }
+    }
+
+    /* every segment carries the current ackno, so sending anything settles a delayed ACK */
     void send(const TCPSenderMessage& sender_message, const TransmitFunction& transmit) {
         TCPMessage msg {sender_message, receiver_.send()};
         transmit(std::move(msg));
         need_send_ = false;
+        segments_unacked_ = 0;
+        ack_deadline_.reset();
     }
 
     bool linger_after_streams_finish_ {true}; // one peer may need to linger to make sure all closure conditions met
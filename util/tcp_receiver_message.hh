@@ -2,25 +2,49 @@
 
 #include "wrapping_integers.hh"
 
+#include <cstddef>
+#include <cstdint>
 #include <optional>
+#include <vector>
 
 /*
  * The TCPReceiverMessage structure contains the information sent from a TCP receiver to its sender.
  *
- * It contains three fields:
+ * It contains six fields:
  *
  * 1) The acknowledgment number (ackno): the *next* sequence number needed by the TCP Receiver.
  *    This is an optional field that is empty if the TCPReceiver hasn't yet received the Initial Sequence Number.
  *
  * 2) The window size. This is the number of sequence numbers that the TCP receiver is interested
- *    to receive, starting from the ackno if present. The maximum value is 65,535 (UINT16_MAX from
- *    the <cstdint> header).
+ *    to receive, starting from the ackno if present, in units of 2^window_scale (see 5). The maximum
+ *    value is 65,535 (UINT16_MAX from the <cstdint> header).
  *
  * 3) The RST (reset) flag. If set, the stream has suffered an error and the connection should be aborted.
+ *
+ * 4) The SACK blocks (RFC 2018): ranges of sequence numbers beyond the ackno that the receiver already holds,
+ *    the one containing the most recently received segment first. Only sent if the peer's SYN permitted it.
+ *
+ * 5) The window scale (RFC 7323): the window is window_size << window_scale bytes, which lets it exceed
+ *    64 KiB. Empty if the window is not scaled. On the wire, the shift is negotiated once, on the SYNs.
+ *
+ * 6) The maximum segment size: the largest payload the receiver accepts in one segment. On the wire, it is
+ *    sent once, on the SYN, and bounded by the MTU.
  */
 
+// The sequence numbers [left, right) held by the receiver
+struct SACKBlock {
+    Wrap32 left;
+    Wrap32 right;
+};
+
 struct TCPReceiverMessage {
+    static constexpr size_t MAX_SACK_BLOCKS = 4;    // as many as fit in the TCP header's options
+    static constexpr uint8_t MAX_WINDOW_SCALE = 14; // windows up to 1 GiB (RFC 7323 2.3)
+
     std::optional<Wrap32> ackno {};
     uint16_t window_size {};
     bool RST {};
+    std::vector<SACKBlock> sack_blocks {};
+    std::optional<uint8_t> window_scale {};
+    std::optional<uint16_t> max_segment_size {};
 };
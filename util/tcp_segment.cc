@@ -2,19 +2,54 @@
 #include "checksum.hh"
 #include "wrapping_integers.hh"
 
+#include <algorithm>
 #include <cstddef>
 
-static constexpr uint32_t TCPHeaderMinLen = 5; // 32-bit words
+static constexpr uint32_t TCPHeaderMinLen = TCPSegment::MIN_HEADER_LENGTH / 4; // 32-bit words
 
 using namespace std;
 
-void TCPSegment::parse(Parser& parser, uint32_t datagram_layer_pseudo_checksum) {
-    /* verify checksum */
-    InternetChecksum check {datagram_layer_pseudo_checksum};
-    check.add(parser.buffer());
-    if (check.value()) {
-        parser.set_error();
-        return;
+namespace {
+/* TCP option kinds */
+constexpr uint8_t OptionEnd = 0;
+constexpr uint8_t OptionNoOp = 1;
+constexpr uint8_t OptionMaxSegmentSize = 2;
+constexpr uint8_t OptionWindowScale = 3;
+constexpr uint8_t OptionSACKPermitted = 4;
+constexpr uint8_t OptionSACK = 5;
+constexpr uint8_t OptionFastOpen = 34;
+
+constexpr uint64_t SACKBlockLen = 8;
+constexpr uint64_t WindowScaleLen = 3;
+constexpr uint64_t MaxSegmentSizeLen = 4;
+constexpr uint64_t FastOpenCookieMinLen = 4; // a cookie is 4 to 16 bytes, or empty to request one (RFC 7413 4.1.1)
+constexpr uint64_t FastOpenCookieMaxLen = 16;
+
+// The window-scale and MSS options are only valid on a SYN (RFC 7323 2.2, RFC 9293 3.7.1)
+bool has_window_scale_option(const TCPMessage& message) {
+    return message.sender.SYN and message.receiver.window_scale.has_value();
+}
+
+bool has_max_segment_size_option(const TCPMessage& message) {
+    return message.sender.SYN and message.receiver.max_segment_size.has_value();
+}
+
+// Fast Open cookies travel only on SYNs, and one too long to fit the option is not sent
+bool has_fast_open_option(const TCPMessage& message) {
+    return message.sender.SYN and message.sender.fast_open_cookie.has_value()
+           and message.sender.fast_open_cookie->size() <= FastOpenCookieMaxLen;
+}
+} // namespace
+
+void TCPSegment::parse(Parser& parser, uint32_t datagram_layer_pseudo_checksum, bool verify_checksum) {
+    /* verify checksum, unless the device did */
+    if (verify_checksum) {
+        InternetChecksum check {datagram_layer_pseudo_checksum};
+        check.add(parser.buffer());
+        if (check.value()) {
+            parser.set_error();
+            return;
+        }
     }
 
     uint32_t raw32 {};
@@ -46,15 +81,98 @@ void TCPSegment::parse(Parser& parser, uint32_t datagram_layer_pseudo_checksum)
     parser.integer(udinfo.cksum);
     parser.integer(raw16); // urgent pointer
 
-    // skip any options or anything extra in the header
     if (data_offset < TCPHeaderMinLen) {
         parser.set_error();
+        return;
     }
-    parser.remove_prefix(data_offset * 4 - TCPHeaderMinLen * 4);
+    parse_options(parser, data_offset * 4 - TCPHeaderMinLen * 4);
 
     parser.all_remaining(message.sender.payload);
 }
 
+void TCPSegment::parse_options(Parser& parser, uint64_t length) {
+    while (length > 0 and not parser.has_error()) {
+        uint8_t kind {};
+        parser.integer(kind);
+        --length;
+        if (kind == OptionEnd) {
+            parser.remove_prefix(length);
+            return;
+        }
+        if (kind == OptionNoOp) {
+            continue;
+        }
+
+        uint8_t option_length {};
+        parser.integer(option_length);
+        if (length == 0 or option_length < 2 or option_length - 1U > length) {
+            parser.set_error();
+            return;
+        }
+        length -= option_length - 1;
+        uint64_t body_length = option_length - 2;
+
+        switch (kind) {
+            case OptionMaxSegmentSize:
+                if (body_length >= 2) {
+                    uint16_t mss {};
+                    parser.integer(mss);
+                    body_length -= 2;
+                    if (message.sender.SYN) {
+                        message.receiver.max_segment_size = mss;
+                    }
+                }
+                break;
+            case OptionSACKPermitted:
+                message.sender.SACK_permitted = true;
+                break;
+            case OptionWindowScale:
+                if (body_length >= 1) {
+                    uint8_t shift {};
+                    parser.integer(shift);
+                    --body_length;
+                    if (message.sender.SYN) {
+                        message.receiver.window_scale = shift;
+                    }
+                }
+                break;
+            case OptionFastOpen:
+                if (body_length == 0
+                    or (body_length >= FastOpenCookieMinLen and body_length <= FastOpenCookieMaxLen)) {
+                    message.sender.fast_open_cookie.emplace(body_length, 0);
+                    parser.string(message.sender.fast_open_cookie.value());
+                    body_length = 0;
+                }
+                break;
+            case OptionSACK:
+                while (body_length >= SACKBlockLen) {
+                    uint32_t left {};
+                    uint32_t right {};
+                    parser.integer(left);
+                    parser.integer(right);
+                    message.receiver.sack_blocks.push_back({Wrap32 {left}, Wrap32 {right}});
+                    body_length -= SACKBlockLen;
+                }
+                break;
+            default: // unknown options are skipped
+                break;
+        }
+        parser.remove_prefix(body_length);
+    }
+}
+
+uint64_t TCPSegment::header_length() const {
+    uint64_t options_length = has_max_segment_size_option(message) ? MaxSegmentSizeLen : 0;
+    options_length += message.sender.SACK_permitted ? 2 : 0;
+    options_length += has_window_scale_option(message) ? WindowScaleLen : 0;
+    options_length += has_fast_open_option(message) ? 2 + message.sender.fast_open_cookie->size() : 0;
+    if (not message.receiver.sack_blocks.empty()) {
+        const auto blocks = min(message.receiver.sack_blocks.size(), TCPReceiverMessage::MAX_SACK_BLOCKS);
+        options_length += 2 + blocks * SACKBlockLen;
+    }
+    return TCPHeaderMinLen * 4 + (options_length + 3) / 4 * 4; // padded to whole words
+}
+
 class Wrap32Serializable : public Wrap32 {
   public:
     uint32_t raw_value() const { return raw_value_; }
@@ -65,7 +183,8 @@ void TCPSegment::serialize(Serializer& serializer) const {
     serializer.integer(udinfo.dst_port);
     serializer.integer(Wrap32Serializable {message.sender.seqno}.raw_value());
     serializer.integer(Wrap32Serializable {message.receiver.ackno.value_or(Wrap32 {0})}.raw_value());
-    serializer.integer(uint8_t {TCPHeaderMinLen << 4}); // data offset
+    const uint64_t header_len = header_length();
+    serializer.integer(static_cast<uint8_t>(header_len / 4 << 4)); // data offset
     const bool reset = message.sender.RST or message.receiver.RST;
     const uint8_t flags = (message.receiver.ackno.has_value() ? 0b0001'0000U : 0) | (reset ? 0b0000'0100U : 0)
                           | (message.sender.SYN ? 0b0000'0010U : 0) | (message.sender.FIN ? 0b0000'0001U : 0);
@@ -73,6 +192,49 @@ void TCPSegment::serialize(Serializer& serializer) const {
     serializer.integer(message.receiver.window_size);
     serializer.integer(udinfo.cksum);
     serializer.integer(uint16_t {0}); // urgent pointer
+
+    uint64_t options_length = 0;
+    if (has_max_segment_size_option(message)) {
+        serializer.integer(OptionMaxSegmentSize);
+        serializer.integer(static_cast<uint8_t>(MaxSegmentSizeLen));
+        serializer.integer(message.receiver.max_segment_size.value());
+        options_length += MaxSegmentSizeLen;
+    }
+    if (message.sender.SACK_permitted) {
+        serializer.integer(OptionSACKPermitted);
+        serializer.integer(uint8_t {2});
+        options_length += 2;
+    }
+    if (has_window_scale_option(message)) {
+        serializer.integer(OptionWindowScale);
+        serializer.integer(static_cast<uint8_t>(WindowScaleLen));
+        serializer.integer(message.receiver.window_scale.value());
+        options_length += WindowScaleLen;
+    }
+    if (has_fast_open_option(message)) {
+        const auto& cookie = message.sender.fast_open_cookie.value();
+        serializer.integer(OptionFastOpen);
+        serializer.integer(static_cast<uint8_t>(2 + cookie.size()));
+        for (const char c : cookie) {
+            serializer.integer(static_cast<uint8_t>(c));
+        }
+        options_length += 2 + cookie.size();
+    }
+    if (not message.receiver.sack_blocks.empty()) {
+        const auto blocks = min(message.receiver.sack_blocks.size(), TCPReceiverMessage::MAX_SACK_BLOCKS);
+        serializer.integer(OptionSACK);
+        serializer.integer(static_cast<uint8_t>(2 + blocks * SACKBlockLen));
+        for (size_t i = 0; i < blocks; ++i) {
+            const auto& block = message.receiver.sack_blocks[i];
+            serializer.integer(Wrap32Serializable {block.left}.raw_value());
+            serializer.integer(Wrap32Serializable {block.right}.raw_value());
+        }
+        options_length += 2 + blocks * SACKBlockLen;
+    }
+    for (; options_length < header_len - TCPHeaderMinLen * 4; ++options_length) {
+        serializer.integer(OptionEnd);
+    }
+
     serializer.buffer(message.sender.payload);
 }
 
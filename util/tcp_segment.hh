@@ -5,17 +5,28 @@
 #include "tcp_sender_message.hh"
 #include "udinfo.hh"
 
+#include <cstdint>
+
 struct TCPMessage {
     TCPSenderMessage sender {};
     TCPReceiverMessage receiver {};
 };
 
 struct TCPSegment {
+    static constexpr uint64_t MIN_HEADER_LENGTH = 20; // without options
+
     TCPMessage message {};
     UserDatagramInfo udinfo {};
 
-    void parse(Parser& parser, uint32_t datagram_layer_pseudo_checksum);
+    // Without `verify_checksum`, the checksum is taken as verified already (by the device, with checksum offload)
+    void parse(Parser& parser, uint32_t datagram_layer_pseudo_checksum, bool verify_checksum = true);
     void serialize(Serializer& serializer) const;
 
+    // Length of the serialized header, including options
+    uint64_t header_length() const;
+
     void compute_checksum(uint32_t datagram_layer_pseudo_checksum);
+
+  private:
+    void parse_options(Parser& parser, uint64_t length);
 };
@@ -2,12 +2,13 @@
 
 #include "wrapping_integers.hh"
 
+#include <optional>
 #include <string>
 
 /*
  * The TCPSenderMessage structure contains the information sent from a TCP sender to its receiver.
  *
- * It contains five fields:
+ * It contains seven fields:
  *
  * 1) The sequence number (seqno) of the beginning of the segment. If the SYN flag is set, this is the
  *    sequence number of the SYN flag. Otherwise, it's the sequence number of the beginning of the payload.
@@ -20,6 +21,13 @@
  * 4) The FIN flag. If set, the payload represents the ending of the byte stream.
  *
  * 5) The RST (reset) flag. If set, the stream has suffered an error and the connection should be aborted.
+ *
+ * 6) The SACK-permitted option, carried on a SYN: the sender can make use of SACK blocks (RFC 2018) from the
+ *    peer's receiver.
+ *
+ * 7) The Fast Open cookie (RFC 7413), carried on a SYN. On a client's SYN, an empty cookie requests one, and a
+ *    cookie the server issued earlier lets the server accept the SYN's payload. On a server's SYN, it is the
+ *    cookie issued to the client.
  */
 
 struct TCPSenderMessage {
@@ -31,6 +39,10 @@ struct TCPSenderMessage {
 
     bool RST {};
 
+    bool SACK_permitted {};
+
+    std::optional<std::string> fast_open_cookie {};
+
     // How many sequence numbers does this segment use?
     size_t sequence_length() const { return SYN + payload.size() + FIN; }
 };
@@ -4,18 +4,29 @@
 #include <linux/if.h>
 #include <linux/if_tun.h>
 #include <sys/ioctl.h>
+#include <sys/socket.h>
 
+#include <array>
+#include <cstdint>
 #include <cstring>
+#include <string_view>
 
 #include "exception.hh"
 
 static constexpr const char* CLONEDEV = "/dev/net/tun";
 
+// struct virtio_net_hdr, from linux/virtio_net.h (which is not valid C++): the flags are its first byte
+static constexpr size_t VNET_HDR_LEN = 10;
+static constexpr uint8_t VNET_HDR_F_NEEDS_CSUM = 1;
+static constexpr uint8_t VNET_HDR_F_DATA_VALID = 2;
+
 using namespace std;
 
 //! \param[in] devname is the name of the TUN or TAP device, specified at its creation.
 //! \param[in] is_tun is `true` for a TUN device (expects IP datagrams), or `false` for a TAP device (expects
 //! Ethernet frames)
+//! \param[in] checksum_offload asks the kernel to leave TCP checksums of datagrams sent from this host to the
+//! device (TUN_F_CSUM), and to say which datagrams need no verification in a virtio_net_hdr (IFF_VNET_HDR)
 //!
 //! To create a TUN device, you should already have run
 //!
@@ -23,11 +34,14 @@ using namespace std;
 //!
 //! as root before calling this function.
 
-TunTapFD::TunTapFD(const string& devname, const bool is_tun)
-  : FileDescriptor(::CheckSystemCall("open", open(CLONEDEV, O_RDWR | O_CLOEXEC))) {
+TunTapFD::TunTapFD(const string& devname, const bool is_tun, const bool checksum_offload)
+  : FileDescriptor(::CheckSystemCall("open", open(CLONEDEV, O_RDWR | O_CLOEXEC)))
+  , checksum_offload_(checksum_offload) {
     struct ifreq tun_req {};
 
-    tun_req.ifr_flags = static_cast<int16_t>((is_tun ? IFF_TUN : IFF_TAP) | IFF_NO_PI); // no packetinfo
+    // no packetinfo, but with checksum offload, a virtio_net_hdr
+    tun_req.ifr_flags
+      = static_cast<int16_t>((is_tun ? IFF_TUN : IFF_TAP) | IFF_NO_PI | (checksum_offload ? IFF_VNET_HDR : 0));
 
     // copy devname to ifr_name, making sure to null terminate
 
@@ -35,4 +49,50 @@ TunTapFD::TunTapFD(const string& devname, const bool is_tun)
     tun_req.ifr_name[IFNAMSIZ - 1] = '\0';
 
     CheckSystemCall("ioctl", ioctl(fd_num(), TUNSETIFF, static_cast<void*>(&tun_req)));
+    if (checksum_offload) {
+        CheckSystemCall("ioctl", ioctl(fd_num(), TUNSETOFFLOAD, TUN_F_CSUM));
+    }
+}
+
+size_t TunTapFD::mtu() const {
+    struct ifreq req {};
+    CheckSystemCall("ioctl", ioctl(fd_num(), TUNGETIFF, static_cast<void*>(&req)));
+
+    // the MTU is an interface attribute, queried through any socket
+    const FileDescriptor sock {CheckSystemCall("socket", socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0))};
+    CheckSystemCall("ioctl", ioctl(sock.fd_num(), SIOCGIFMTU, static_cast<void*>(&req)));
+    return static_cast<size_t>(req.ifr_mtu);
+}
+
+bool TunTapFD::read_datagram(FileDescriptor& fd, const bool checksum_offload, vector<string>& buffers) {
+    if (not checksum_offload) {
+        fd.read(buffers);
+        return false;
+    }
+
+    buffers.insert(buffers.begin(), string(VNET_HDR_LEN, 0));
+    fd.read(buffers);
+    if (buffers.empty()) { // nothing to read
+        return false;
+    }
+    const uint8_t flags = buffers.front().empty() ? 0 : static_cast<uint8_t>(buffers.front().front());
+    buffers.erase(buffers.begin());
+
+    // DATA_VALID: the kernel verified the checksum. NEEDS_CSUM: the datagram comes from this host, and its checksum
+    // field holds only the pseudo-header's sum, left for the device to complete
+    return (flags & (VNET_HDR_F_DATA_VALID | VNET_HDR_F_NEEDS_CSUM)) != 0;
+}
+
+void TunTapFD::write_datagram(FileDescriptor& fd, const bool checksum_offload, const vector<string>& buffers) {
+    if (not checksum_offload) {
+        fd.write(buffers);
+        return;
+    }
+
+    static constexpr array<char, VNET_HDR_LEN> complete {}; // no flags: the checksum is complete
+    vector<string_view> views;
+    views.reserve(buffers.size() + 1);
+    views.emplace_back(complete.data(), complete.size());
+    views.insert(views.end(), buffers.begin(), buffers.end());
+    fd.write(views);
 }
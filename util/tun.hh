@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
+#include <vector>
 
 #include "file_descriptor.hh"
 
@@ -9,14 +11,45 @@ class TunTapFD : public FileDescriptor {
   public:
     //! Open an existing persistent [TUN or TAP
     //! device](https://www.kernel.org/doc/Documentation/networking/tuntap.txt).
-    explicit TunTapFD(const std::string& devname, bool is_tun);
+    //! With `checksum_offload`, the kernel may hand over datagrams whose TCP checksum it verified, or never
+    //! computed for a datagram sent from this host, and says so in a virtio_net_hdr before each one.
+    explicit TunTapFD(const std::string& devname, bool is_tun, bool checksum_offload = false);
+
+    //! The device's MTU
+    size_t mtu() const;
+
+    //! Whether the device was opened with checksum offload, and frames each datagram with a virtio_net_hdr
+    bool checksum_offload() const { return checksum_offload_; }
+
+    //! Read one datagram into `buffers` (as FileDescriptor::read)
+    //! \returns whether the kernel vouched for its TCP checksum
+    bool read_datagram(std::vector<std::string>& buffers) {
+        return read_datagram(*this, checksum_offload_, buffers);
+    }
+
+    //! Write one datagram
+    void write_datagram(const std::vector<std::string>& buffers) {
+        write_datagram(*this, checksum_offload_, buffers);
+    }
+
+    //! \name
+    //! The same, for a device held as a plain FileDescriptor
+
+    //!@{
+    static bool read_datagram(FileDescriptor& fd, bool checksum_offload, std::vector<std::string>& buffers);
+    static void write_datagram(FileDescriptor& fd, bool checksum_offload, const std::vector<std::string>& buffers);
+    //!@}
+
+  private:
+    bool checksum_offload_;
 };
 
 //! A FileDescriptor to a [Linux TUN](https://www.kernel.org/doc/Documentation/networking/tuntap.txt) device
 class TunFD : public TunTapFD {
   public:
     //! Open an existing persistent [TUN device](https://www.kernel.org/doc/Documentation/networking/tuntap.txt).
-    explicit TunFD(const std::string& devname) : TunTapFD(devname, true) {}
+    explicit TunFD(const std::string& devname, bool checksum_offload = false)
+      : TunTapFD(devname, true, checksum_offload) {}
 };
 
 //! A FileDescriptor to a [Linux TAP](https://www.kernel.org/doc/Documentation/networking/tuntap.txt) device
@@ -6,12 +6,12 @@ using namespace std;
 optional<TCPMessage> TCPOverIPv4OverTunFdAdapter::read() {
     vector<string> strs(2);
     strs.front().resize(IPv4Header::LENGTH);
-    _tun.read(strs);
+    const bool checksum_verified = _tun.read_datagram(strs);
 
     InternetDatagram ip_dgram;
     const vector<string> buffers = {strs.at(0), strs.at(1)};
     if (parse(ip_dgram, buffers)) {
-        return unwrap_tcp_in_ip(ip_dgram);
+        return unwrap_tcp_in_ip(ip_dgram, checksum_verified);
     }
     return {};
 }
@@ -21,14 +21,15 @@ class TCPOverIPv4OverTunFdAdapter : public TCPOverIPv4Adapter {
     TunFD _tun;
 
   public:
-    //! Construct from a TunFD
-    explicit TCPOverIPv4OverTunFdAdapter(TunFD&& tun) : _tun(std::move(tun)) {}
+    //! Construct from a TunFD, bounding segments by its MTU
+    explicit TCPOverIPv4OverTunFdAdapter(TunFD&& tun) : _tun(std::move(tun)) { set_mtu(_tun.mtu()); }
 
     //! Attempts to read and parse an IPv4 datagram containing a TCP segment related to the current connection
+    //! (skipping the checksum if the device vouched for it; see TunTapFD::checksum_offload)
     std::optional<TCPMessage> read();
 
     //! Creates an IPv4 datagram from a TCP segment and writes it to the TUN device
-    void write(const TCPMessage& seg) { _tun.write(serialize(wrap_tcp_in_ip(seg))); }
+    void write(const TCPMessage& seg) { _tun.write_datagram(serialize_tcp_in_ip(seg)); }
 
     //! Access the underlying TUN device
     explicit operator TunFD&() { return _tun; }